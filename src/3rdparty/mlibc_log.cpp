@@ -0,0 +1,5 @@
+#include "mlibc_log.h"
+
+// Process wide logger, set up once by mlibc_log_init() before any emulator runs and only read after that.
+// Logging without an instance is a no-op, so embedders that never call mlibc_log_init() get silence.
+mlibc_log_logger * mlibc_log_instance = NULL;
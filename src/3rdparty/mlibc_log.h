@@ -5,6 +5,10 @@
 #include <stdio.h>
 #include <stdarg.h>
 
+#ifdef __cplusplus
+#include <atomic>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -29,6 +33,16 @@ extern "C" {
 #define MLIBC_LOG_CODE_LOG_ERR  4
 #define MLIBC_LOG_CODE_LOG_NOP  5
 
+// Lowest logging level compiled in, calls below it are removed entirely (0: DBG, 1: INF, 2: WRN, 3: ERR, 4: none)
+#ifndef MLIBC_LOG_LEVEL_MIN
+#define MLIBC_LOG_LEVEL_MIN 0
+#endif
+
+// Rate limited call sites log their first MLIBC_LOG_RATE_BURST messages, then only every power of two,
+// counting stops at MLIBC_LOG_RATE_CAP so a site that keeps firing costs one shared read
+#define MLIBC_LOG_RATE_BURST 8
+#define MLIBC_LOG_RATE_CAP   (1u << 24)
+
 // Logger logging levels
 typedef enum
 {
@@ -53,6 +67,7 @@ extern mlibc_log_logger * mlibc_log_instance;
 // Function API
 inline int mlibc_log_init(mlibc_log_level_t level);
 inline int mlibc_log_free();
+inline int mlibc_log_enabled(mlibc_log_level_t level);
 inline int mlibc_vlog(mlibc_log_level_t level, const char * msg, va_list args);
 inline int mlibc_log(mlibc_log_level_t level, const char * msg, ...);
 inline int mlibc_dbg(const char * msg, ...);
@@ -104,6 +119,17 @@ int mlibc_log_free()
 	return MLIBC_LOG_CODE_OK;
 }
 
+// ----------------------------------------------------------------------------
+// -- Function
+// ----------------------------------------------------------------------------
+// -- Would a message at level get through
+// -- * arg: mlibc_log_level_t level
+// ----------------------------------------------------------------------------
+int mlibc_log_enabled(mlibc_log_level_t level)
+{
+	return level >= MLIBC_LOG_LEVEL_MIN && mlibc_log_instance != NULL && level >= mlibc_log_instance->level;
+}
+
 // ----------------------------------------------------------------------------
 // -- Function
 // ----------------------------------------------------------------------------
@@ -285,4 +311,61 @@ int mlibc_err(const char * msg, ...)
 }
 #endif
 
+// ----------------------------------------------------------------------------
+// -- Macros
+// ----------------------------------------------------------------------------
+// -- Compile-time elimination, the arguments are still type checked but never evaluated
+// ----------------------------------------------------------------------------
+#define MLIBC_LOG_NOP(level, ...) ((void)(0 && mlibc_log(level, __VA_ARGS__)), MLIBC_LOG_CODE_LOG_NOP)
+
+#if MLIBC_LOG_LEVEL_MIN > 0
+#define mlibc_dbg(...) MLIBC_LOG_NOP(MLIBC_LOG_LEVEL_DBG, __VA_ARGS__)
+#endif
+#if MLIBC_LOG_LEVEL_MIN > 1
+#define mlibc_inf(...) MLIBC_LOG_NOP(MLIBC_LOG_LEVEL_INF, __VA_ARGS__)
+#endif
+#if MLIBC_LOG_LEVEL_MIN > 2
+#define mlibc_wrn(...) MLIBC_LOG_NOP(MLIBC_LOG_LEVEL_WRN, __VA_ARGS__)
+#endif
+#if MLIBC_LOG_LEVEL_MIN > 3
+#define mlibc_err(...) MLIBC_LOG_NOP(MLIBC_LOG_LEVEL_ERR, __VA_ARGS__)
+#endif
+
+// ----------------------------------------------------------------------------
+// -- Macros
+// ----------------------------------------------------------------------------
+// -- Per call site rate limiting, for messages that may repeat on hot paths
+// -- * arg: mlibc_log_level_t level
+// -- * arg: const char * msg (string literal)
+// -- * arg: ...
+// ----------------------------------------------------------------------------
+#ifdef __cplusplus
+#define MLIBC_LOG_COUNTER         std::atomic<unsigned>
+#define MLIBC_LOG_COUNT(counter)  (counter).load(std::memory_order_relaxed)
+#define MLIBC_LOG_INC(counter)    ((counter).fetch_add(1, std::memory_order_relaxed) + 1)
+#else
+#define MLIBC_LOG_COUNTER         unsigned
+#define MLIBC_LOG_COUNT(counter)  (counter)
+#define MLIBC_LOG_INC(counter)    (++(counter))
+#endif
+
+#define mlibc_log_limited(level, msg, ...) \
+	do \
+	{ \
+		static MLIBC_LOG_COUNTER mlibc_log_site_count; \
+		if (mlibc_log_enabled(level) && MLIBC_LOG_COUNT(mlibc_log_site_count) < MLIBC_LOG_RATE_CAP) \
+		{ \
+			unsigned mlibc_log_site_n = MLIBC_LOG_INC(mlibc_log_site_count); \
+			if (mlibc_log_site_n <= MLIBC_LOG_RATE_BURST) \
+				mlibc_log(level, msg, ##__VA_ARGS__); \
+			else if ((mlibc_log_site_n & (mlibc_log_site_n - 1)) == 0) \
+				mlibc_log(level, msg " (%u times)", ##__VA_ARGS__, mlibc_log_site_n); \
+		} \
+	} while (0)
+
+#define mlibc_dbg_limited(msg, ...) mlibc_log_limited(MLIBC_LOG_LEVEL_DBG, msg, ##__VA_ARGS__)
+#define mlibc_inf_limited(msg, ...) mlibc_log_limited(MLIBC_LOG_LEVEL_INF, msg, ##__VA_ARGS__)
+#define mlibc_wrn_limited(msg, ...) mlibc_log_limited(MLIBC_LOG_LEVEL_WRN, msg, ##__VA_ARGS__)
+#define mlibc_err_limited(msg, ...) mlibc_log_limited(MLIBC_LOG_LEVEL_ERR, msg, ##__VA_ARGS__)
+
 #endif // MLIBC_LOG
\ No newline at end of file
@@ -0,0 +1,63 @@
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "3rdparty/mlibc_log.h"
+#include "emu/batch.h"
+#include "cpu/profile.h"
+#include "emu/boot_cache.h"
+
+// Runs a job list over all cores, prints one tab separated result line per job in job order
+int main(int argc, char * argv[])
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "usage: %s <jobs> [workers] [screenshot dir] [boot cache dir|-|boot] [profile.csv|.json]\n", argv[0]);
+		return 1;
+	}
+
+	int workers = (argc > 2) ? atoi(argv[2]) : 0;
+	std::string screenshot_dir = (argc > 3) ? argv[3] : ".";
+	// Skip the boot ROM, post-boot states are kept in the given directory between runs, - sets the registers directly
+	std::string boot = (argc > 4) ? argv[4] : "";
+	std::unique_ptr<hgb::BootCache> boot_cache((!boot.empty() && boot != "-" && boot != "boot") ? new hgb::BootCache(boot) : NULL);
+	// Opcode counts & cycles over every job
+	std::unique_ptr<hgb::Profile> profile((argc > 5) ? new hgb::Profile() : NULL);
+
+	// Init mlibc_log, errors only
+	int return_code = mlibc_log_init(MLIBC_LOG_LEVEL_ERR);
+	if (return_code != MLIBC_LOG_CODE_OK)
+	{
+		throw std::runtime_error("::main(), mlibc_log_init error: " + std::to_string(return_code));
+	}
+
+	std::vector<hgb::BatchJob> jobs = hgb::loadBatchJobs(argv[1], screenshot_dir);
+	std::vector<hgb::BatchResult> results = hgb::runBatch(jobs, workers, boot_cache.get(), boot != "-", profile.get());
+
+	if (profile)
+		profile->write(argv[5]);
+
+	int failed = 0;
+	printf("job\trom\tstatus\tram_hash\tcycles\tseconds\tworker\n");
+	for (size_t i = 0; i < jobs.size(); i++)
+	{
+		const hgb::BatchResult & result = results[i];
+
+		printf("%zu\t%s\t%s\t%016llx\t%llu\t%.3f\t%d\n",
+			   i,
+			   jobs[i].rom.c_str(),
+			   (result.ok) ? "ok" : result.error.c_str(),
+			   static_cast<unsigned long long>(result.ram_hash),
+			   static_cast<unsigned long long>(result.cycles),
+			   result.seconds,
+			   result.worker
+		);
+
+		failed += (result.ok) ? 0 : 1;
+	}
+
+	mlibc_log_free();
+
+	return (failed > 0) ? 1 : 0;
+}
@@ -0,0 +1,148 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "3rdparty/mlibc_log.h"
+#include "cpu/profile.h"
+#include "emu/bench_rom.h"
+#include "emu/emulator.h"
+#include "emu/frame_pacer.h"
+#include "util/hash.h"
+
+#define BENCH_RUNS	3	// timed runs per kernel, the fastest one is reported
+
+struct BenchResult
+{
+	uint64_t cycles;
+	uint64_t instructions;
+	double seconds;
+	uint64_t screen;
+};
+
+// Fresh machine started at the entry point, the boot ROM would dominate short runs
+static std::unique_ptr<hgb::Emulator> boot(const std::string & rom)
+{
+	std::unique_ptr<hgb::Emulator> emu(new hgb::Emulator());
+	emu->loadROM(rom);
+	emu->skipBootROM();
+
+	return emu;
+}
+
+static BenchResult run(const std::string & rom, unsigned frames)
+{
+	BenchResult result = {};
+
+	// Emulation is deterministic, count instructions in an untimed run so the timed ones have no hooks attached
+	{
+		std::unique_ptr<hgb::Emulator> emu = boot(rom);
+		hgb::Profile profile;
+		emu->getCPU().setProfile(&profile);
+
+		for (unsigned i = 0; i < frames; i++)
+		{
+			emu->runFrame();
+		}
+
+		for (int table = 0; table < PROFILE_TABLES; table++)
+		{
+			for (int op = 0; op < 256; op++)
+			{
+				result.instructions += profile.get(table, static_cast<byte>(op)).count;
+			}
+		}
+	}
+
+	for (int i = 0; i < BENCH_RUNS; i++)
+	{
+		std::unique_ptr<hgb::Emulator> emu = boot(rom);
+		uint64_t cycles = 0;
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (unsigned frame = 0; frame < frames; frame++)
+		{
+			cycles += emu->runFrame();
+		}
+
+		emu->getPPU().flush();
+
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		if (i == 0 || seconds < result.seconds)
+			result.seconds = seconds;
+
+		result.cycles = cycles;
+		result.screen = hgb::fnv1a(emu->getPPU().getFramebuffer(), PPU_LCD_W * PPU_LCD_H);
+	}
+
+	return result;
+}
+
+// Runs every synthetic kernel for a fixed number of frames, prints the results as JSON
+int main(int argc, char * argv[])
+{
+	if (argc > 1 && argv[1][0] == '-')
+	{
+		fprintf(stderr, "usage: %s [frames] [rom dir] [results.json|-]\n", argv[0]);
+		return 1;
+	}
+
+	unsigned frames = (argc > 1) ? static_cast<unsigned>(strtoul(argv[1], NULL, 10)) : 600;
+	std::string rom_dir = (argc > 2) ? argv[2] : ".";
+	std::string json_fp = (argc > 3 && std::string(argv[3]) != "-") ? argv[3] : "";
+
+	// Init mlibc_log, errors only
+	int return_code = mlibc_log_init(MLIBC_LOG_LEVEL_ERR);
+	if (return_code != MLIBC_LOG_CODE_OK)
+	{
+		throw std::runtime_error("::main(), mlibc_log_init error: " + std::to_string(return_code));
+	}
+
+	std::unique_ptr<FILE, int(*)(FILE *)> file((json_fp.empty()) ? stdout : fopen(json_fp.c_str(), "w"), [](FILE * f)
+	{
+		return (f != stdout) ? fclose(f) : 0;
+	});
+
+	if (!file)
+		throw std::runtime_error("::main(), error! Cannot open " + json_fp);
+
+	fprintf(file.get(), "{\n\t\"frames\": %u,\n\t\"runs\": %d,\n\t\"benchmarks\": [", frames, BENCH_RUNS);
+
+	for (int kind = 0; kind < BENCH_ROM_COUNT; kind++)
+	{
+		std::string rom = rom_dir + "/bench_" + hgb::BenchROM::getName(kind) + ".gb";
+		hgb::BenchROM::write(kind, rom);
+
+		BenchResult result = run(rom, frames);
+		double seconds = (result.seconds > 0.0) ? result.seconds : 1e-9;
+
+		// A kernel that halts for good runs too few instructions to divide by
+		char ns_per_instruction[32] = "null";
+		if (result.instructions >= frames)
+			snprintf(ns_per_instruction, sizeof(ns_per_instruction), "%.3f", seconds * 1e9 / result.instructions);
+
+		fprintf(file.get(), "%s\n\t\t{ \"name\": \"%s\", \"cycles\": %llu, \"instructions\": %llu, \"seconds\": %.6f, "
+				"\"mhz\": %.2f, \"fps\": %.1f, \"speed\": %.2f, \"ns_per_instruction\": %s, \"screen\": \"%016llx\" }",
+				(kind > 0) ? "," : "",
+				hgb::BenchROM::getName(kind),
+				static_cast<unsigned long long>(result.cycles),
+				static_cast<unsigned long long>(result.instructions),
+				result.seconds,
+				result.cycles / seconds / 1e6,
+				frames / seconds,
+				result.cycles / (seconds * PPU_CYCLES_FRAME * FRAME_PACER_HZ),
+				ns_per_instruction,
+				static_cast<unsigned long long>(result.screen)
+		);
+		fflush(file.get());
+	}
+
+	fprintf(file.get(), "\n\t]\n}\n");
+
+	mlibc_log_free();
+
+	return 0;
+}
@@ -1,6 +1,8 @@
 #include "cpu.h"
+#include <algorithm>
 #include "3rdparty/mlibc_log.h"
 #include "data_types.h"
+#include "util/async_log.h"
 #include "mem/mmu.h"
 
 namespace hgb
@@ -13,7 +15,10 @@ CPU::CPU(
 	m_registers(),
 	m_state(),
 	m_alu(this),
-	m_breakpoints()
+	m_breakpoints(),
+	m_trace(nullptr),
+	m_profile(nullptr),
+	m_sampler(nullptr)
 {
 	// Setup CPU registers
 	m_registers.AF = 0x0000;
@@ -45,37 +50,59 @@ void CPU::tick()
 		// Did we hit a breakpoint? If so, print info
 		if (std::find(m_breakpoints.begin(), m_breakpoints.end(), m_registers.PC) != m_breakpoints.end())
 		{
-			mlibc_dbg("CPU::tick(). Breakpoint hit. PC: 0x%04zx, SP: 0x%04zx, OP: 0x%02zx, STATE: %d, CLOCK: %d",
+			hgb_dbg("CPU::tick(). Breakpoint hit. PC: 0x%04zx, SP: 0x%04zx, OP: 0x%02zx, STATE: %d, CLOCK: %lld",
 					  m_registers.PC,
 					  m_registers.SP,
 					  m_mmu.read(m_registers.PC),
 					  m_state.STATE,
-					  m_state.CLOCK
+					  static_cast<long long>(m_state.CLOCK)
 			);
-			mlibc_dbg("A: 0x%02zx, F: 0x%02zx, B: 0x%02zx, C: 0x%02zx, D: 0x%02zx, E: 0x%02zx, H: 0x%02zx, L: 0x%02zx",
+			hgb_dbg("A: 0x%02zx, F: 0x%02zx, B: 0x%02zx, C: 0x%02zx, D: 0x%02zx, E: 0x%02zx, H: 0x%02zx, L: 0x%02zx",
 					  m_registers.A, m_registers.F, m_registers.B, m_registers.C, m_registers.D, m_registers.E, m_registers.H, m_registers.L
 			);
-			mlibc_dbg("Z: %d, N: %d, H: %d, C: %d", m_registers.checkZ(), m_registers.checkN(), m_registers.checkH(), m_registers.checkC());
+			hgb_dbg("Z: %d, N: %d, H: %d, C: %d", m_registers.checkZ(), m_registers.checkN(), m_registers.checkH(), m_registers.checkC());
 		}
 	}
 
+	// Where the tick started, for the profilers
+	int64_t clock = m_state.CLOCK;
+	CPUState::CPUState_t state = m_state.STATE;
+	word sp = m_registers.SP;
+	byte opcode = 0x00;
+
 	// Execute normal or cb opcode or do nothing while halted/stopped
 	switch (m_state.STATE)
 	{
 		case CPUState::NORMAL:
 		{
-			op(m_mmu.read(m_registers.PC++));
+			if (m_trace != nullptr)
+				m_trace->record(static_cast<uint64_t>(m_state.CLOCK), m_registers, m_mmu);
+
+			opcode = m_mmu.read(m_registers.PC++);
+			op(opcode);
+
+			if (m_profile != nullptr)
+				m_profile->count(PROFILE_OP, opcode, static_cast<int>(m_state.CLOCK - clock));
 		} break;
 		case CPUState::PREFIX_CB:
 		{
-			cb(m_mmu.read(m_registers.PC++));
+			opcode = m_mmu.read(m_registers.PC++);
+			cb(opcode);
+
+			if (m_profile != nullptr)
+				m_profile->count(PROFILE_CB, opcode, static_cast<int>(m_state.CLOCK - clock));
 		} break;
 		case CPUState::HALT:
 		case CPUState::STOP:
 		{
-			mlibc_wrn("CPU::tick(), warning! CPU Is halted or stopped!");
+			// Time still passes while halted
+			m_state.CLOCK += 4;
+			mlibc_wrn_limited("CPU::tick(), warning! CPU Is halted or stopped!");
 		} break;
 	}
+
+	if (m_sampler != nullptr)
+		m_sampler->step(*this, state, opcode, sp, static_cast<int>(m_state.CLOCK - clock));
 }
 
 void CPU::op(byte op)
@@ -466,7 +493,7 @@ void CPU::op(byte op)
 		} break;
 
 		default:
-			mlibc_err("CPU::OP(), error! Unknown OPCODE 0x%02zx!", op);
+			mlibc_err_limited("CPU::OP(), error! Unknown OPCODE 0x%02zx!", op);
 	}
 }
 
@@ -761,7 +788,7 @@ void CPU::cb(byte op)
 		case 0xFF: m_alu.SET(7, m_registers.A); break;
 
 		default:
-			mlibc_err("CPU::CB(), error! Unknown OPCODE 0x%02zx!", op);
+			mlibc_err_limited("CPU::CB(), error! Unknown OPCODE 0x%02zx!", op);
 	}
 
 	// Set state back to normal
@@ -848,4 +875,34 @@ std::vector<word> & CPU::getBreakpoints()
 	return m_breakpoints;
 }
 
+void CPU::setTrace(Trace * trace)
+{
+	m_trace = trace;
+}
+
+Trace * CPU::getTrace()
+{
+	return m_trace;
+}
+
+void CPU::setProfile(Profile * profile)
+{
+	m_profile = profile;
+}
+
+Profile * CPU::getProfile()
+{
+	return m_profile;
+}
+
+void CPU::setSampler(Sampler * sampler)
+{
+	m_sampler = sampler;
+}
+
+Sampler * CPU::getSampler()
+{
+	return m_sampler;
+}
+
 }
\ No newline at end of file
@@ -5,6 +5,9 @@
 #include "alu.h"
 #include "cpu_registers.h"
 #include "cpu_state.h"
+#include "profile.h"
+#include "sampler.h"
+#include "trace.h"
 
 namespace hgb
 {
@@ -37,12 +40,24 @@ public:
 	CPUState & getState();
 	ALU & getALU();
 	std::vector<word> & getBreakpoints();
+	// Record every instruction into trace, NULL turns tracing off
+	void setTrace(Trace * trace);
+	Trace * getTrace();
+	// Count every executed opcode into profile, NULL turns profiling off
+	void setProfile(Profile * profile);
+	Profile * getProfile();
+	// Sample the running guest code into sampler, NULL turns sampling off
+	void setSampler(Sampler * sampler);
+	Sampler * getSampler();
 private:
 	MMU & m_mmu;
 	CPURegisters m_registers;
 	CPUState m_state;
 	ALU m_alu;
 	std::vector<word> m_breakpoints;
+	Trace * m_trace;
+	Profile * m_profile;
+	Sampler * m_sampler;
 };
 
 }
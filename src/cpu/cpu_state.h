@@ -1,13 +1,15 @@
 #ifndef CPU_STATE_H
 #define CPU_STATE_H
 
+#include <cstdint>
+
 namespace hgb
 {
 
 struct CPUState
 {
-	// # of current clock cycle
-	int CLOCK;
+	// # of current clock cycle, 64-bit so it does not wrap in any realistic session
+	int64_t CLOCK;
 
 	// Interrupts enabled or not
 	bool IME;
@@ -14,6 +14,23 @@ IRQ::IRQ() :
 
 }
 
+void IRQ::request(byte flags)
+{
+	IF |= flags;
+}
+
+void IRQ::saveState(IRQState & state)
+{
+	state.IF = IF;
+	state.IE = IE;
+}
+
+void IRQ::loadState(const IRQState & state)
+{
+	IF = state.IF;
+	IE = state.IE;
+}
+
 byte IRQ::read(word addr)
 {
 	if (addr == IRQ_REG_IF)
@@ -9,11 +9,31 @@ namespace hgb
 #define IRQ_REG_IF	0xFF0F	// interrupt flags (R/W)
 #define IRQ_REG_IE	0xFFFF	// interrupt enable (R/W)
 
+// Interrupt flag bits
+#define IRQ_VBLANK	0x01	// vblank
+#define IRQ_STAT	0x02	// lcd stat
+#define IRQ_TIMER	0x04	// timer overflow
+#define IRQ_SERIAL	0x08	// serial transfer complete
+#define IRQ_JOYPAD	0x10	// joypad input
+
+// Savestate image
+struct IRQState
+{
+	byte IF;
+	byte IE;
+};
+
 class IRQ : public MemoryArea
 {
 public:
 	IRQ();
 
+	// Raise interrupt flag(s) in IF
+	void request(byte flags);
+
+	void saveState(IRQState & state);
+	void loadState(const IRQState & state);
+
 	virtual byte read(word addr) override;
 	virtual void write(word addr, byte value) override;
 private:
@@ -0,0 +1,145 @@
+#include "profile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "3rdparty/mlibc_log.h"
+
+namespace hgb
+{
+
+struct ProfileRow
+{
+	int table;
+	int op;
+	ProfileEntry entry;
+};
+
+// Opcodes that ran, most cycles first
+static std::vector<ProfileRow> sortedRows(const ProfileEntry (&entries)[PROFILE_TABLES][256], uint64_t & total_count, uint64_t & total_cycles)
+{
+	std::vector<ProfileRow> rows;
+	total_count = 0;
+	total_cycles = 0;
+
+	for (int table = 0; table < PROFILE_TABLES; table++)
+	{
+		for (int op = 0; op < 256; op++)
+		{
+			const ProfileEntry & entry = entries[table][op];
+
+			if (entry.count == 0)
+				continue;
+
+			rows.push_back({ table, op, entry });
+			total_count += entry.count;
+			total_cycles += entry.cycles;
+		}
+	}
+
+	std::stable_sort(rows.begin(), rows.end(), [](const ProfileRow & a, const ProfileRow & b)
+	{
+		return a.entry.cycles > b.entry.cycles;
+	});
+
+	return rows;
+}
+
+static std::unique_ptr<FILE, int(*)(FILE *)> openFile(const std::string & fp)
+{
+	std::unique_ptr<FILE, int(*)(FILE *)> file(fopen(fp.c_str(), "w"), fclose);
+
+	if (!file)
+		throw std::runtime_error("Profile::write(...), error! Cannot open " + fp);
+
+	return file;
+}
+
+Profile::Profile() :
+	m_entries()
+{
+
+}
+
+void Profile::clear()
+{
+	std::memset(m_entries, 0, sizeof(m_entries));
+}
+
+void Profile::merge(const Profile & other)
+{
+	for (int table = 0; table < PROFILE_TABLES; table++)
+	{
+		for (int op = 0; op < 256; op++)
+		{
+			m_entries[table][op].count += other.m_entries[table][op].count;
+			m_entries[table][op].cycles += other.m_entries[table][op].cycles;
+		}
+	}
+}
+
+const ProfileEntry & Profile::get(int table, byte op)
+{
+	return m_entries[table][op];
+}
+
+void Profile::writeCSV(const std::string & fp)
+{
+	uint64_t total_count, total_cycles;
+	std::vector<ProfileRow> rows = sortedRows(m_entries, total_count, total_cycles);
+	auto file = openFile(fp);
+
+	fprintf(file.get(), "table,opcode,count,cycles,cycles_per_op,cycle_share\n");
+	for (const ProfileRow & row : rows)
+	{
+		fprintf(file.get(), "%s,0x%02X,%llu,%llu,%.2f,%.6f\n",
+				(row.table == PROFILE_CB) ? "cb" : "op",
+				row.op,
+				static_cast<unsigned long long>(row.entry.count),
+				static_cast<unsigned long long>(row.entry.cycles),
+				static_cast<double>(row.entry.cycles) / row.entry.count,
+				(total_cycles > 0) ? static_cast<double>(row.entry.cycles) / total_cycles : 0.0
+		);
+	}
+
+	mlibc_dbg("Profile::writeCSV(%s). opcodes: %zu", fp.c_str(), rows.size());
+}
+
+void Profile::writeJSON(const std::string & fp)
+{
+	uint64_t total_count, total_cycles;
+	std::vector<ProfileRow> rows = sortedRows(m_entries, total_count, total_cycles);
+	auto file = openFile(fp);
+
+	fprintf(file.get(), "{\n\t\"count\": %llu,\n\t\"cycles\": %llu,\n\t\"opcodes\": [",
+			static_cast<unsigned long long>(total_count),
+			static_cast<unsigned long long>(total_cycles)
+	);
+	for (size_t i = 0; i < rows.size(); i++)
+	{
+		const ProfileRow & row = rows[i];
+
+		fprintf(file.get(), "%s\n\t\t{ \"table\": \"%s\", \"opcode\": \"0x%02X\", \"count\": %llu, \"cycles\": %llu }",
+				(i > 0) ? "," : "",
+				(row.table == PROFILE_CB) ? "cb" : "op",
+				row.op,
+				static_cast<unsigned long long>(row.entry.count),
+				static_cast<unsigned long long>(row.entry.cycles)
+		);
+	}
+	fprintf(file.get(), "\n\t]\n}\n");
+
+	mlibc_dbg("Profile::writeJSON(%s). opcodes: %zu", fp.c_str(), rows.size());
+}
+
+void Profile::write(const std::string & fp)
+{
+	if (fp.size() >= 5 && fp.compare(fp.size() - 5, 5, ".json") == 0)
+		writeJSON(fp);
+	else
+		writeCSV(fp);
+}
+
+}
@@ -0,0 +1,53 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <cstdint>
+#include <string>
+#include "data_types.h"
+
+namespace hgb
+{
+
+// Opcode tables
+#define PROFILE_OP		0	// normal opcodes
+#define PROFILE_CB		1	// PREFIX CB opcodes
+#define PROFILE_TABLES	2
+
+struct ProfileEntry
+{
+	uint64_t count;
+	uint64_t cycles;
+};
+
+// Execution count & emulated cycles of every opcode, attach with CPU::setProfile().
+// A CPU without one pays a single never-taken branch per instruction.
+class Profile
+{
+public:
+	Profile();
+
+	// Called by the CPU after every instruction
+	inline void count(int table, byte op, int cycles)
+	{
+		ProfileEntry & entry = m_entries[table][op];
+		entry.count++;
+		entry.cycles += cycles;
+	}
+
+	void clear();
+	// Add the counters of another profile, e.g. one per worker thread
+	void merge(const Profile & other);
+	const ProfileEntry & get(int table, byte op);
+
+	// Executed opcodes sorted by cycles, most expensive first. Throws if the file cannot be written
+	void writeCSV(const std::string & fp);
+	void writeJSON(const std::string & fp);
+	// JSON for a .json file, CSV otherwise
+	void write(const std::string & fp);
+private:
+	ProfileEntry m_entries[PROFILE_TABLES][256];
+};
+
+}
+
+#endif // PROFILE_H
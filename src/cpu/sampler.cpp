@@ -0,0 +1,314 @@
+#include "sampler.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include "3rdparty/mlibc_log.h"
+#include "cpu/cpu.h"
+#include "mem/mmu.h"
+
+namespace hgb
+{
+
+static std::unique_ptr<FILE, int(*)(FILE *)> openReport(const std::string & fp)
+{
+	std::unique_ptr<FILE, int(*)(FILE *)> file(fopen(fp.c_str(), "w"), fclose);
+
+	if (!file)
+		throw std::runtime_error("Sampler::write(...), error! Cannot open " + fp);
+
+	return file;
+}
+
+Sampler::Sampler(
+	int interval
+) :
+	m_interval(std::max(interval, 1)),
+	m_cycles(0),
+	m_samples(0),
+	m_stack(),
+	m_overflow(0),
+	m_stacks(),
+	m_key(),
+	m_symbols()
+{
+	mlibc_dbg("Sampler::Sampler(interval:%d)", m_interval);
+}
+
+void Sampler::step(CPU & cpu, CPUState::CPUState_t state, byte op, word sp, int cycles)
+{
+	CPURegisters & registers = cpu.getRegisters();
+
+	if (state == CPUState::NORMAL)
+	{
+		switch (op)
+		{
+			// CALL nn, CALL cc, nn & RST n, taken when the return address was pushed
+			case 0xCD:
+			case 0xC4:
+			case 0xD4:
+			case 0xCC:
+			case 0xDC:
+			case 0xC7:
+			case 0xD7:
+			case 0xE7:
+			case 0xF7:
+			case 0xCF:
+			case 0xDF:
+			case 0xEF:
+			case 0xFF:
+			{
+				if (registers.SP != static_cast<word>(sp - 2))
+					break;
+
+				if (m_stack.size() < SAMPLER_STACK_MAX)
+					m_stack.push_back({ location(cpu, registers.PC), registers.SP });
+				else
+					m_overflow++;
+			} break;
+			// RET, RET cc & RETI, taken when the return address was popped
+			case 0xC9:
+			case 0xC0:
+			case 0xD0:
+			case 0xC8:
+			case 0xD8:
+			case 0xD9:
+			{
+				if (registers.SP != static_cast<word>(sp + 2))
+					break;
+
+				if (m_overflow > 0)
+				{
+					m_overflow--;
+					break;
+				}
+
+				// Frames the program dropped by moving SP itself sit above the one being returned from
+				while (!m_stack.empty() && m_stack.back().sp <= sp)
+				{
+					m_stack.pop_back();
+				}
+			} break;
+		}
+	}
+
+	m_cycles += cycles;
+
+	while (m_cycles >= m_interval)
+	{
+		m_cycles -= m_interval;
+
+		m_key.clear();
+		for (const Frame & frame : m_stack)
+		{
+			m_key.push_back(frame.target);
+		}
+		m_key.push_back(location(cpu, registers.PC));
+
+		m_stacks[m_key]++;
+		m_samples++;
+	}
+}
+
+void Sampler::clear()
+{
+	m_cycles = 0;
+	m_samples = 0;
+	m_stack.clear();
+	m_overflow = 0;
+	m_stacks.clear();
+}
+
+bool Sampler::loadSymbols(const std::string & fp)
+{
+	std::ifstream file(fp);
+
+	if (!file)
+		return false;
+
+	m_symbols.clear();
+
+	std::string line;
+	while (std::getline(file, line))
+	{
+		std::stringstream ss(line);
+		std::string address, name;
+
+		if (!(ss >> address >> name) || address[0] == ';')
+			continue;
+
+		unsigned bank, addr;
+		if (sscanf(address.c_str(), "%x:%x", &bank, &addr) != 2 || addr > 0xFFFF)
+			continue;
+
+		m_symbols.push_back({ (bank & 0xFFFF) << 16 | addr, name });
+	}
+
+	std::stable_sort(m_symbols.begin(), m_symbols.end(), [](const Symbol & a, const Symbol & b)
+	{
+		return a.location < b.location;
+	});
+
+	mlibc_dbg("Sampler::loadSymbols(%s). symbols: %zu", fp.c_str(), m_symbols.size());
+
+	return true;
+}
+
+void Sampler::writeReport(const std::string & fp)
+{
+	std::map<std::string, uint64_t> self;
+	std::map<std::string, uint64_t> total;
+
+	for (const auto & stack : m_stacks)
+	{
+		std::vector<std::string> routines = getRoutines(stack.first);
+		self[routines.back()] += stack.second;
+
+		// Recursion counts once per stack
+		std::set<std::string> names(routines.begin(), routines.end());
+		for (const std::string & name : names)
+		{
+			total[name] += stack.second;
+		}
+	}
+
+	std::vector<std::pair<std::string, uint64_t>> rows(total.begin(), total.end());
+	std::stable_sort(rows.begin(), rows.end(), [&](const std::pair<std::string, uint64_t> & a, const std::pair<std::string, uint64_t> & b)
+	{
+		return (self[a.first] != self[b.first]) ? self[a.first] > self[b.first] : a.second > b.second;
+	});
+
+	auto file = openReport(fp);
+	double scale = (m_samples > 0) ? 100.0 / m_samples : 0.0;
+
+	fprintf(file.get(), "# samples: %llu, interval: %d cycles\n", static_cast<unsigned long long>(m_samples), m_interval);
+	fprintf(file.get(), "# %7s %8s %10s  %s\n", "self %", "total %", "self", "routine");
+	for (const auto & row : rows)
+	{
+		fprintf(file.get(), "  %7.2f %8.2f %10llu  %s\n",
+				self[row.first] * scale,
+				row.second * scale,
+				static_cast<unsigned long long>(self[row.first]),
+				row.first.c_str()
+		);
+	}
+
+	mlibc_dbg("Sampler::writeReport(%s). routines: %zu", fp.c_str(), rows.size());
+}
+
+void Sampler::writeCollapsed(const std::string & fp)
+{
+	// Stacks that differ only within a routine fold together
+	std::map<std::string, uint64_t> folded;
+
+	for (const auto & stack : m_stacks)
+	{
+		std::string names;
+		for (const std::string & name : getRoutines(stack.first))
+		{
+			if (!names.empty())
+				names += ';';
+			names += name;
+		}
+
+		folded[names] += stack.second;
+	}
+
+	auto file = openReport(fp);
+
+	for (const auto & stack : folded)
+	{
+		fprintf(file.get(), "%s %llu\n", stack.first.c_str(), static_cast<unsigned long long>(stack.second));
+	}
+
+	mlibc_dbg("Sampler::writeCollapsed(%s). stacks: %zu", fp.c_str(), folded.size());
+}
+
+uint64_t Sampler::getSamples()
+{
+	return m_samples;
+}
+
+uint32_t Sampler::location(CPU & cpu, word addr)
+{
+	MMU & mmu = cpu.getMMU();
+	uint32_t bank = 0;
+
+	if (addr <= MMU_ROM_BOOT_E && mmu.getFF50() == 0x00)
+		bank = SAMPLER_BANK_BOOT;
+	else if (addr >= MMU_ROM_BANK_X && addr < MMU_VRAM)
+		bank = static_cast<uint32_t>(mmu.getROMBank());
+
+	return bank << 16 | addr;
+}
+
+bool Sampler::lookup(uint32_t location, std::string & name)
+{
+	// Closest symbol at or below, in the same bank & memory area
+	auto it = std::upper_bound(m_symbols.begin(), m_symbols.end(), location, [](uint32_t value, const Symbol & symbol)
+	{
+		return value < symbol.location;
+	});
+
+	if (it == m_symbols.begin())
+		return false;
+
+	const Symbol & symbol = *(it - 1);
+
+	if ((symbol.location >> 16) != (location >> 16) || (symbol.location & 0xC000) != (location & 0xC000))
+		return false;
+
+	name = symbol.name;
+
+	return true;
+}
+
+std::string Sampler::symbolise(uint32_t location)
+{
+	std::string name;
+
+	if (lookup(location, name))
+		return name;
+
+	if ((location >> 16) == SAMPLER_BANK_BOOT)
+		return "BOOTROM";
+
+	char address[16];
+	snprintf(address, sizeof(address), "$%02X:%04X", location >> 16, location & 0xFFFF);
+
+	return address;
+}
+
+std::vector<std::string> Sampler::getRoutines(const std::vector<uint32_t> & stack)
+{
+	std::vector<std::string> routines;
+
+	for (size_t i = 0; i + 1 < stack.size(); i++)
+	{
+		routines.push_back(symbolise(stack[i]));
+	}
+
+	uint32_t leaf = stack.back();
+	std::string name;
+
+	if (!lookup(leaf, name))
+	{
+		if (!routines.empty())
+			name = routines.back();
+		else if ((leaf >> 16) == SAMPLER_BANK_BOOT)
+			name = "BOOTROM";
+		else
+			name = SAMPLER_TOP;
+	}
+
+	// The leaf is usually inside the routine called last
+	if (routines.empty() || routines.back() != name)
+		routines.push_back(name);
+
+	return routines;
+}
+
+}
\ No newline at end of file
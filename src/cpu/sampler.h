@@ -0,0 +1,82 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "data_types.h"
+#include "cpu_state.h"
+
+namespace hgb
+{
+
+#define SAMPLER_INTERVAL	1024	// default # of emulated cycles between samples
+#define SAMPLER_STACK_MAX	64		// deeper calls are not tracked
+#define SAMPLER_BANK_BOOT	0xFF	// bank of the boot ROM while it is mapped in
+#define SAMPLER_TOP			"(top)"	// code outside any call or symbol
+
+class CPU;
+
+// Sampling profiler for the emulated program. Every interval cycles the (bank, PC) being run is recorded
+// along with a shadow call stack kept from CALL, RST & RET, attach with CPU::setSampler().
+// Reports are symbolised with an RGBDS .sym file when one is loaded.
+class Sampler
+{
+public:
+	Sampler(
+		int interval = SAMPLER_INTERVAL
+	);
+
+	// Called by the CPU after every tick with the state, opcode & SP it started with
+	void step(CPU & cpu, CPUState::CPUState_t state, byte op, word sp, int cycles);
+	void clear();
+
+	// Read "BB:AAAA name" lines of an RGBDS symbol file, returns false if it cannot be opened
+	bool loadSymbols(const std::string & fp);
+	// Self & total samples per routine, hottest first. Throws if the file cannot be written
+	void writeReport(const std::string & fp);
+	// One "caller;callee;leaf count" line per distinct stack, for flamegraph tools
+	void writeCollapsed(const std::string & fp);
+
+	uint64_t getSamples();
+private:
+	struct Frame
+	{
+		// Called routine as bank << 16 | address
+		uint32_t target;
+		// SP right after the return address was pushed
+		word sp;
+	};
+
+	struct Symbol
+	{
+		uint32_t location;
+		std::string name;
+	};
+
+	static uint32_t location(CPU & cpu, word addr);
+	// Symbol a location belongs to, false when no symbol covers it
+	bool lookup(uint32_t location, std::string & name);
+	// Name of a called routine, its address when there is no symbol
+	std::string symbolise(uint32_t location);
+	// Routine names of a sampled stack, outermost first. A leaf outside any symbol is
+	// counted to the routine called last, so samples group by routine even without a .sym
+	std::vector<std::string> getRoutines(const std::vector<uint32_t> & stack);
+
+	int m_interval;
+	int m_cycles;
+	uint64_t m_samples;
+	std::vector<Frame> m_stack;
+	// Calls deeper than SAMPLER_STACK_MAX, their returns are ignored
+	int m_overflow;
+	// Samples per call stack, (bank, PC) of the leaf last
+	std::map<std::vector<uint32_t>, uint64_t> m_stacks;
+	std::vector<uint32_t> m_key;
+	// Sorted by location
+	std::vector<Symbol> m_symbols;
+};
+
+}
+
+#endif // SAMPLER_H
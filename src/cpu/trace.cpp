@@ -0,0 +1,228 @@
+#include "trace.h"
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <signal.h>
+#include <unistd.h>
+#endif
+#include "3rdparty/mlibc_log.h"
+#include "mem/mmu.h"
+
+namespace hgb
+{
+
+struct TraceHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t record_size;
+	uint32_t count;
+};
+
+// Crash dump target, set by dumpOnCrash()
+static Trace * s_crash_trace = NULL;
+static char s_crash_fp[1024];
+
+// Raw file descriptors, open & write are async-signal-safe where FILE is not
+static int openTrace(const char * fp)
+{
+#ifdef _WIN32
+	return _open(fp, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+	return open(fp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+}
+
+static void closeTrace(int fd)
+{
+#ifdef _WIN32
+	_close(fd);
+#else
+	close(fd);
+#endif
+}
+
+static bool writeAll(int fd, const void * data, size_t size)
+{
+	const char * bytes = static_cast<const char *>(data);
+
+	while (size > 0)
+	{
+#ifdef _WIN32
+		int written = _write(fd, bytes, static_cast<unsigned>(size));
+#else
+		ssize_t written = write(fd, bytes, size);
+#endif
+		if (written <= 0)
+			return false;
+
+		bytes += written;
+		size -= static_cast<size_t>(written);
+	}
+
+	return true;
+}
+
+// Header & records oldest first with plain write calls, nothing allocates so the crash handler can use it too
+static bool writeTrace(int fd, const TraceRecord * records, size_t mask, uint64_t next)
+{
+	size_t size = mask + 1;
+	size_t count = (next < size) ? static_cast<size_t>(next) : size;
+	size_t start = static_cast<size_t>(next - count) & mask;
+	size_t first = (start + count <= size) ? count : size - start;
+
+	TraceHeader header = { TRACE_MAGIC, TRACE_VERSION, sizeof(TraceRecord), static_cast<uint32_t>(count) };
+
+	return writeAll(fd, &header, sizeof(header)) &&
+		   writeAll(fd, records + start, sizeof(TraceRecord) * first) &&
+		   writeAll(fd, records, sizeof(TraceRecord) * (count - first));
+}
+
+Trace::Trace(
+	size_t size
+) :
+	m_records(),
+	m_mask(0),
+	m_next(0)
+{
+	if (size == 0 || (size & (size - 1)) != 0)
+		throw std::runtime_error("Trace::Trace(...), error! Size must be a power of two!");
+
+	m_records.reset(new TraceRecord[size]);
+	m_mask = size - 1;
+
+	mlibc_dbg("Trace::Trace(size:%zu)", size);
+}
+
+Trace::~Trace()
+{
+	if (s_crash_trace == this)
+		s_crash_trace = NULL;
+}
+
+void Trace::record(uint64_t cycle, const CPURegisters & registers, MMU & mmu)
+{
+	TraceRecord & record = m_records[m_next++ & m_mask];
+	record.cycle = cycle;
+	record.PC = registers.PC;
+	record.AF = registers.AF;
+	record.BC = registers.BC;
+	record.DE = registers.DE;
+	record.HL = registers.HL;
+	record.SP = registers.SP;
+	record.op[0] = mmu.peek(registers.PC);
+	record.op[1] = mmu.peek(static_cast<word>(registers.PC + 1));
+	record.op[2] = mmu.peek(static_cast<word>(registers.PC + 2));
+	record.pad = 0x00;
+}
+
+void Trace::clear()
+{
+	m_next = 0;
+}
+
+void Trace::dump(const std::string & fp)
+{
+	int fd = openTrace(fp.c_str());
+
+	if (fd < 0)
+		throw std::runtime_error("Trace::dump(...), error! Cannot open " + fp);
+
+	bool written = writeTrace(fd, m_records.get(), m_mask, m_next);
+	closeTrace(fd);
+
+	if (!written)
+		throw std::runtime_error("Trace::dump(...), error! Cannot write " + fp);
+
+	mlibc_dbg("Trace::dump(%s). records: %zu", fp.c_str(), getCount());
+}
+
+void Trace::dumpOnCrash(const std::string & fp)
+{
+	// The path is copied now, the handler cannot build strings
+	snprintf(s_crash_fp, sizeof(s_crash_fp), "%s", fp.c_str());
+	s_crash_trace = this;
+
+	const int signals[] = { SIGSEGV, SIGABRT, SIGFPE, SIGILL };
+#ifdef _WIN32
+	for (int sig : signals)
+	{
+		std::signal(sig, onCrash);
+	}
+#else
+	// One shot, the default action is back in place by the time the handler runs
+	struct sigaction action;
+	std::memset(&action, 0, sizeof(action));
+	action.sa_handler = onCrash;
+	action.sa_flags = SA_RESETHAND;
+	sigemptyset(&action.sa_mask);
+
+	for (int sig : signals)
+	{
+		sigaction(sig, &action, NULL);
+	}
+#endif
+}
+
+void Trace::onCrash(int sig)
+{
+	// Async-signal-safe calls only, the heap may be what is broken
+	int fd = (s_crash_trace != NULL) ? openTrace(s_crash_fp) : -1;
+
+	if (fd >= 0)
+	{
+		writeTrace(fd, s_crash_trace->m_records.get(), s_crash_trace->m_mask, s_crash_trace->m_next);
+		closeTrace(fd);
+	}
+
+#ifdef _WIN32
+	std::signal(sig, SIG_DFL);
+#endif
+	// Delivered with the default action once the handler returns, also for signals that were sent rather than faults
+	std::raise(sig);
+}
+
+size_t Trace::getCount()
+{
+	return (m_next <= m_mask) ? static_cast<size_t>(m_next) : m_mask + 1;
+}
+
+std::vector<TraceRecord> Trace::getRecords()
+{
+	size_t count = getCount();
+	std::vector<TraceRecord> records(count);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		records[i] = m_records[(m_next - count + i) & m_mask];
+	}
+
+	return records;
+}
+
+std::vector<TraceRecord> Trace::load(const std::string & fp)
+{
+	std::unique_ptr<FILE, int(*)(FILE *)> file(fopen(fp.c_str(), "rb"), fclose);
+
+	if (!file)
+		throw std::runtime_error("Trace::load(...), error! Cannot open " + fp);
+
+	TraceHeader header;
+	if (fread(&header, sizeof(header), 1, file.get()) != 1 ||
+		header.magic != TRACE_MAGIC || header.version != TRACE_VERSION || header.record_size != sizeof(TraceRecord))
+		throw std::runtime_error("Trace::load(...), error! Not a trace of this version: " + fp);
+
+	std::vector<TraceRecord> records(header.count);
+	if (header.count > 0 && fread(records.data(), sizeof(TraceRecord), header.count, file.get()) != header.count)
+		throw std::runtime_error("Trace::load(...), error! Truncated trace: " + fp);
+
+	return records;
+}
+
+}
@@ -0,0 +1,73 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "data_types.h"
+#include "cpu_registers.h"
+
+namespace hgb
+{
+
+#define TRACE_SZ		65536		// default # of instructions kept, power of two
+#define TRACE_MAGIC		0x54424748	// "HGBT"
+#define TRACE_VERSION	2
+
+class MMU;
+
+// One executed instruction, registers as they were before it ran
+struct TraceRecord
+{
+	uint64_t cycle;
+	word PC;
+	word AF;
+	word BC;
+	word DE;
+	word HL;
+	word SP;
+	// Bytes at PC, the instruction and whatever follows it, peeked so DMA locks & I/O reads do not change them
+	byte op[3];
+	byte pad;
+};
+
+static_assert(sizeof(TraceRecord) == 24, "TraceRecord must stay packed, it is written to disk as is");
+
+// Fixed-size ring of the last executed instructions, attach with CPU::setTrace().
+// A CPU without one pays a single never-taken branch per instruction.
+class Trace
+{
+public:
+	Trace(
+		size_t size = TRACE_SZ
+	);
+	~Trace();
+
+	// Called by the CPU before every instruction
+	void record(uint64_t cycle, const CPURegisters & registers, MMU & mmu);
+	void clear();
+	// Write the ring to a file, oldest record first
+	void dump(const std::string & fp);
+	// Dump to fp when the process crashes (SIGSEGV, SIGABRT, SIGFPE, SIGILL), best effort, one trace per process
+	void dumpOnCrash(const std::string & fp);
+
+	// # of records in the ring, at most the ring size
+	size_t getCount();
+	// Records oldest first
+	std::vector<TraceRecord> getRecords();
+
+	// Read a dumped trace, throws on a bad file
+	static std::vector<TraceRecord> load(const std::string & fp);
+private:
+	static void onCrash(int sig);
+
+	std::unique_ptr<TraceRecord[]> m_records;
+	size_t m_mask;
+	uint64_t m_next;
+};
+
+}
+
+#endif // TRACE_H
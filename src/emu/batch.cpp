@@ -0,0 +1,221 @@
+#include "batch.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include "3rdparty/mlibc_log.h"
+#include "emu/boot_cache.h"
+#include "emu/emulator.h"
+#include "util/hash.h"
+#include "util/work_stealing_pool.h"
+
+namespace hgb
+{
+
+static int parseOutputs(const std::string & outputs)
+{
+	int result = 0;
+	std::stringstream ss(outputs);
+	std::string output;
+
+	while (std::getline(ss, output, ','))
+	{
+		if (output == "hash")
+			result |= BATCH_OUTPUT_RAM_HASH;
+		else if (output == "screenshot")
+			result |= BATCH_OUTPUT_SCREENSHOT;
+		else if (output == "timing")
+			result |= BATCH_OUTPUT_TIMING;
+		else if (output == "all")
+			result |= BATCH_OUTPUT_ALL;
+		else
+			throw std::runtime_error("hgb::parseOutputs(...), error! Unknown output: " + output);
+	}
+
+	return result;
+}
+
+std::vector<BatchJob> loadBatchJobs(const std::string & fp, const std::string & screenshot_dir)
+{
+	std::ifstream file(fp);
+
+	if (!file)
+		throw std::runtime_error("hgb::loadBatchJobs(...), error! Cannot open " + fp);
+
+	std::vector<BatchJob> jobs;
+	std::string line;
+	int line_number = 0;
+
+	while (std::getline(file, line))
+	{
+		line_number++;
+
+		std::stringstream ss(line);
+		std::string rom, movie, outputs;
+		unsigned frames = 0;
+
+		if (!(ss >> rom) || rom[0] == '#')
+			continue;
+
+		if (!(ss >> frames))
+			throw std::runtime_error("hgb::loadBatchJobs(...), error! Missing frame count on line " + std::to_string(line_number));
+
+		BatchJob job;
+		job.rom = rom;
+		job.frames = frames;
+		job.outputs = (ss >> movie >> outputs) ? parseOutputs(outputs) : BATCH_OUTPUT_ALL;
+		job.screenshot = screenshot_dir + "/job_" + std::to_string(jobs.size()) + ".pgm";
+
+		if (!movie.empty() && movie != "-")
+			job.movie = loadBatchMovie(movie);
+
+		jobs.push_back(job);
+	}
+
+	mlibc_dbg("hgb::loadBatchJobs(%s). jobs: %zu", fp.c_str(), jobs.size());
+
+	return jobs;
+}
+
+std::vector<BatchInput> loadBatchMovie(const std::string & fp)
+{
+	std::ifstream file(fp);
+
+	if (!file)
+		throw std::runtime_error("hgb::loadBatchMovie(...), error! Cannot open " + fp);
+
+	std::vector<BatchInput> movie;
+	std::string line;
+
+	while (std::getline(file, line))
+	{
+		std::stringstream ss(line);
+		unsigned frame;
+		std::string keys;
+
+		if (!(ss >> frame >> keys))
+			continue;
+
+		movie.push_back({ frame, static_cast<byte>(strtoul(keys.c_str(), NULL, 16)) });
+	}
+
+	std::stable_sort(movie.begin(), movie.end(), [](const BatchInput & a, const BatchInput & b)
+	{
+		return a.frame < b.frame;
+	});
+
+	return movie;
+}
+
+static void writeScreenshot(const std::string & fp, const byte * framebuffer)
+{
+	FILE * file_ptr = fopen(fp.c_str(), "wb");
+
+	if (file_ptr == NULL)
+		throw std::runtime_error("hgb::writeScreenshot(...), error! fopen returned a NULL pointer!");
+
+	// 2-bit grayscale, shade 0 is the lightest
+	byte pixels[PPU_LCD_W * PPU_LCD_H];
+	for (int i = 0; i < PPU_LCD_W * PPU_LCD_H; i++)
+	{
+		pixels[i] = 3 - (framebuffer[i] & 0x03);
+	}
+
+	fprintf(file_ptr, "P5\n%d %d\n3\n", PPU_LCD_W, PPU_LCD_H);
+	fwrite(pixels, sizeof(pixels), 1, file_ptr);
+	fclose(file_ptr);
+}
+
+BatchResult runBatchJob(const BatchJob & job, BootCache * boot_cache, bool boot_rom, Profile * profile)
+{
+	BatchResult result = {};
+
+	try
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		Emulator emu;
+		emu.loadROM(job.rom);
+
+		if (boot_cache != NULL)
+			boot_cache->boot(emu);
+		else if (!boot_rom)
+			emu.skipBootROM();
+
+		emu.getCPU().setProfile(profile);
+
+		size_t input = 0;
+		for (unsigned frame = 0; frame < job.frames; frame++)
+		{
+			// Apply the held keys from the movie
+			for (; input < job.movie.size() && job.movie[input].frame <= frame; input++)
+			{
+				emu.getJoypad().setKeys(0xFF, false);
+				emu.getJoypad().setKeys(job.movie[input].keys, true);
+			}
+
+			result.cycles += emu.runFrame();
+		}
+
+		emu.getPPU().flush();
+
+		if (job.outputs & BATCH_OUTPUT_RAM_HASH)
+		{
+			// Cart RAM & WRAM, then HRAM, the echo and register pages are left out
+			byte page[0x100];
+			result.ram_hash = HASH_FNV1A_SEED;
+
+			for (int p = MMU_RAM_BANK_X >> 8; p < MMU_RAM_BANK_E >> 8; p++)
+			{
+				emu.getMMU().peek(static_cast<byte>(p), page);
+				result.ram_hash = fnv1a(page, sizeof(page), result.ram_hash);
+			}
+
+			emu.getMMU().peek(MMU_HRAM >> 8, page);
+			result.ram_hash = fnv1a(page + (MMU_HRAM & 0xFF), MMU_HRAM_SZ, result.ram_hash);
+		}
+
+		if (job.outputs & BATCH_OUTPUT_SCREENSHOT)
+			writeScreenshot(job.screenshot, emu.getPPU().getFramebuffer());
+
+		if (job.outputs & BATCH_OUTPUT_TIMING)
+			result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		result.ok = true;
+	}
+	catch (const std::exception & e)
+	{
+		result.ok = false;
+		result.error = e.what();
+	}
+
+	return result;
+}
+
+std::vector<BatchResult> runBatch(const std::vector<BatchJob> & jobs, int workers, BootCache * boot_cache, bool boot_rom, Profile * profile)
+{
+	std::vector<BatchResult> results(jobs.size());
+	WorkStealingPool pool(workers);
+	// One profile per worker, merged once all jobs are done
+	std::vector<Profile> profiles((profile != NULL) ? pool.getWorkers() : 0);
+
+	mlibc_dbg("hgb::runBatch(...). jobs: %zu, workers: %d", jobs.size(), pool.getWorkers());
+
+	pool.run(jobs.size(), [&](int worker, size_t index)
+	{
+		results[index] = runBatchJob(jobs[index], boot_cache, boot_rom, (profile != NULL) ? &profiles[worker] : NULL);
+		results[index].worker = worker;
+	});
+
+	for (const Profile & worker_profile : profiles)
+	{
+		profile->merge(worker_profile);
+	}
+
+	return results;
+}
+
+}
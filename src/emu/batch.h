@@ -0,0 +1,65 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "data_types.h"
+
+namespace hgb
+{
+
+// Wanted job outputs
+#define BATCH_OUTPUT_RAM_HASH	0x01	// hash of cart RAM, WRAM & HRAM after the last frame
+#define BATCH_OUTPUT_SCREENSHOT	0x02	// last frame as a PGM image
+#define BATCH_OUTPUT_TIMING		0x04	// wall clock time & emulated cycles
+#define BATCH_OUTPUT_ALL		0x07
+
+class BootCache;
+class Profile;
+
+// Joypad state change, keys (JOYPAD_* bits) are held from frame on
+struct BatchInput
+{
+	unsigned frame;
+	byte keys;
+};
+
+struct BatchJob
+{
+	std::string rom;
+	unsigned frames;
+	// Sorted by frame, empty for no input
+	std::vector<BatchInput> movie;
+	int outputs;
+	// Where to write the screenshot when BATCH_OUTPUT_SCREENSHOT is set
+	std::string screenshot;
+};
+
+struct BatchResult
+{
+	bool ok;
+	std::string error;
+	uint64_t ram_hash;
+	uint64_t cycles;
+	double seconds;
+	// Worker thread that ran the job
+	int worker;
+};
+
+// Parse a job list, one job per line: <rom> <frames> [movie|-] [outputs]
+// outputs is a comma separated list of hash, screenshot, timing or all, defaults to all.
+// Blank lines and lines starting with # are skipped, screenshots go to <screenshot_dir>/job_<job #>.pgm
+std::vector<BatchJob> loadBatchJobs(const std::string & fp, const std::string & screenshot_dir = ".");
+// Parse an input movie, one change per line: <frame> <keys in hex>
+std::vector<BatchInput> loadBatchMovie(const std::string & fp);
+// Run all jobs over a work-stealing pool, one emulator per worker at a time, workers <= 0 uses every core.
+// With a boot cache or without the boot ROM the jobs start at the cartridge entry point, frames count from there.
+// With a profile the opcodes of every job are counted into it
+std::vector<BatchResult> runBatch(const std::vector<BatchJob> & jobs, int workers = 0, BootCache * boot_cache = NULL, bool boot_rom = true, Profile * profile = NULL);
+// Run a single job on the calling thread
+BatchResult runBatchJob(const BatchJob & job, BootCache * boot_cache = NULL, bool boot_rom = true, Profile * profile = NULL);
+
+}
+
+#endif // BATCH_H
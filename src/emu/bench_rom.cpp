@@ -0,0 +1,256 @@
+#include "bench_rom.h"
+#include <cctype>
+#include <cstdio>
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include "3rdparty/mlibc_log.h"
+#include "mem/bootrom.h"
+#include "mem/cartridge.h"
+
+namespace hgb
+{
+
+#define BENCH_ROM_ENTRY		0x0100	// cartridge entry point
+#define BENCH_ROM_LOGO		0x0104	// logo the boot ROM compares against its own copy
+#define BENCH_ROM_CODE		0x0150	// kernel, right after the header
+#define BENCH_ROM_SUB		0x0200	// subroutines
+#define BENCH_ROM_DATA		0x1000	// memcpy source
+
+static const char * BENCH_ROM_NAMES[BENCH_ROM_COUNT] =
+{
+	"alu",
+	"memcpy",
+	"call",
+	"halt",
+	"bank",
+	"io"
+};
+
+// Writes machine code into a ROM image, no labels, jumps take absolute targets
+class BenchAssembler
+{
+public:
+	BenchAssembler(
+		std::vector<byte> & rom,
+		word pc
+	) :
+		m_rom(rom),
+		m_pc(pc)
+	{
+
+	}
+
+	void emit(std::initializer_list<byte> bytes)
+	{
+		for (byte b : bytes)
+		{
+			m_rom[m_pc++] = b;
+		}
+	}
+
+	// JR / JR cc to target, which must be within 128 bytes
+	void jr(byte op, word target)
+	{
+		int offset = static_cast<int>(target) - (m_pc + 2);
+
+		if (offset < -128 || offset > 127)
+			throw std::runtime_error("BenchAssembler::jr(...), error! Target out of range!");
+
+		emit({ op, static_cast<byte>(offset) });
+	}
+
+	// CALL nn / JP nn style, little endian operand
+	void abs(byte op, word target)
+	{
+		emit({ op, lsb(target), msb(target) });
+	}
+
+	word here()
+	{
+		return m_pc;
+	}
+private:
+	std::vector<byte> & m_rom;
+	word m_pc;
+};
+
+const char * BenchROM::getName(int kind)
+{
+	return (kind >= 0 && kind < BENCH_ROM_COUNT) ? BENCH_ROM_NAMES[kind] : "?";
+}
+
+std::vector<byte> BenchROM::build(int kind)
+{
+	if (kind < 0 || kind >= BENCH_ROM_COUNT)
+		throw std::runtime_error("BenchROM::build(...), error! Unknown kernel: " + std::to_string(kind));
+
+	std::vector<byte> rom(BENCH_ROM_SZ, 0x00);
+
+	// Header: NOP, JP to the kernel, logo, title & an MBC1 for the bank kernel
+	BenchAssembler entry(rom, BENCH_ROM_ENTRY);
+	entry.emit({ 0x00 });
+	entry.abs(0xC3, BENCH_ROM_CODE);
+
+	std::copy(BOOTROM_DMG01 + 0xA8, BOOTROM_DMG01 + 0xD8, rom.begin() + BENCH_ROM_LOGO);
+
+	std::string title = std::string("HGB ") + getName(kind);
+	for (size_t i = 0; i < title.size(); i++)
+	{
+		rom[CRT_GAME_TITLE_S + i] = static_cast<byte>(toupper(title[i]));
+	}
+
+	rom[CRT_TYPE] = (kind == BENCH_ROM_BANK) ? CRT_TYPE_MBC1 : CRT_TYPE_ROM_ONLY;
+	rom[CRT_ROM_SIZE] = CRT_ROM_SZ_32KB;
+	rom[CRT_RAM_SIZE] = CRT_RAM_SZ_NONE;
+	rom[CRT_DEST_CODE] = CRT_DEST_CODE_UNIVERSAL;
+
+	// Interrupts off & a known stack, whether the boot ROM ran or not
+	BenchAssembler a(rom, BENCH_ROM_CODE);
+	a.emit({ 0xF3 });					// DI
+	a.abs(0x31, 0xFFFE);				// LD SP, $FFFE
+
+	switch (kind)
+	{
+		case BENCH_ROM_ALU:
+		{
+			a.emit({ 0x3E, 0x01, 0x06, 0x03, 0x0E, 0x05 });	// LD A, 1 / LD B, 3 / LD C, 5
+			word loop = a.here();
+			a.emit({
+				0x80,			// ADD A, B
+				0xA9,			// XOR C
+				0x91,			// SUB C
+				0xCB, 0x37,		// SWAP A
+				0x07,			// RLCA
+				0x2F,			// CPL
+				0x3C,			// INC A
+				0xB0,			// OR B
+				0xE6, 0x7F,		// AND $7F
+				0x87,			// ADD A, A
+				0x04,			// INC B
+				0x0D			// DEC C
+			});
+			a.jr(0x18, loop);
+		} break;
+		case BENCH_ROM_MEMCPY:
+		{
+			for (int i = 0; i < 0x1000; i++)
+			{
+				rom[BENCH_ROM_DATA + i] = static_cast<byte>(i * 37);
+			}
+
+			word outer = a.here();
+			a.abs(0x21, BENCH_ROM_DATA);		// LD HL, data
+			a.abs(0x11, 0xC000);				// LD DE, $C000
+			a.abs(0x01, 0x1000);				// LD BC, $1000
+			word inner = a.here();
+			a.emit({
+				0x2A,			// LD A, (HL+)
+				0x12,			// LD (DE), A
+				0x13,			// INC DE
+				0x0B,			// DEC BC
+				0x78,			// LD A, B
+				0xB1			// OR C
+			});
+			a.jr(0x20, inner);
+			a.jr(0x18, outer);
+		} break;
+		case BENCH_ROM_CALL:
+		{
+			word leaf = BENCH_ROM_SUB + 0x10;
+			word loop = a.here();
+			a.abs(0xCD, BENCH_ROM_SUB);			// CALL sub
+			a.abs(0xCD, leaf);					// CALL leaf
+			a.jr(0x18, loop);
+
+			// sub: PUSH BC / INC B / CALL leaf / POP BC / RET
+			BenchAssembler sub(rom, BENCH_ROM_SUB);
+			sub.emit({ 0xC5, 0x04 });
+			sub.abs(0xCD, leaf);
+			sub.emit({ 0xC1, 0xC9 });
+
+			// leaf: INC C / ADD A, C / RET
+			BenchAssembler(rom, leaf).emit({ 0x0C, 0x81, 0xC9 });
+		} break;
+		case BENCH_ROM_HALT:
+		{
+			a.emit({ 0x3E, 0x01, 0xE0, 0xFF });	// IE = VBlank
+			a.emit({ 0xFB });					// EI
+			word loop = a.here();
+			a.emit({ 0x76, 0x00 });				// HALT / NOP
+			a.jr(0x18, loop);
+
+			// VBlank handler
+			BenchAssembler(rom, 0x0040).emit({ 0xD9 });	// RETI
+		} break;
+		case BENCH_ROM_BANK:
+		{
+			// Read back after every switch
+			rom[0x4000] = 0x01;
+
+			a.abs(0x11, 0x2000);				// LD DE, $2000
+			a.emit({ 0x3E, 0x01 });				// LD A, 1
+			word loop = a.here();
+			a.emit({
+				0x12,			// LD (DE), A
+				0x3C,			// INC A
+				0x47			// LD B, A
+			});
+			a.abs(0xFA, 0x4000);				// LD A, ($4000)
+			a.emit({ 0x78 });					// LD A, B
+			a.jr(0x18, loop);
+		} break;
+		case BENCH_ROM_IO:
+		{
+			word loop = a.here();
+			a.emit({ 0xF0, 0x44, 0xFE, 0x90 });	// LDH A, (LY) / CP 144
+			a.jr(0x20, loop);
+			a.emit({
+				0x3E, 0x20, 0xE0, 0x00,			// select the d-pad
+				0xF0, 0x00, 0xF0, 0x00,			// LDH A, (P1) twice
+				0x3E, 0x10, 0xE0, 0x00,			// select the buttons
+				0xF0, 0x00, 0xF0, 0x00,
+				0xF0, 0x41,						// LDH A, (STAT)
+				0xF0, 0x04,						// LDH A, (DIV)
+				0xF0, 0x05						// LDH A, (TIMA)
+			});
+			// Until VBlank line 144 is over
+			word wait = a.here();
+			a.emit({ 0xF0, 0x44, 0xFE, 0x90 });
+			a.jr(0x28, wait);
+			a.jr(0x18, loop);
+		} break;
+	}
+
+	// Header & global checksums
+	byte header = 0;
+	for (int i = CRT_GAME_TITLE_S; i < CRT_HEADER_CHECKSUM; i++)
+	{
+		header = static_cast<byte>(header - rom[i] - 1);
+	}
+	rom[CRT_HEADER_CHECKSUM] = header;
+
+	word global = 0;
+	for (int i = 0; i < BENCH_ROM_SZ; i++)
+	{
+		if (i != CRT_GLOBAL_CHECKSUM_S && i != CRT_GLOBAL_CHECKSUM_E)
+			global = static_cast<word>(global + rom[i]);
+	}
+	rom[CRT_GLOBAL_CHECKSUM_S] = msb(global);
+	rom[CRT_GLOBAL_CHECKSUM_E] = lsb(global);
+
+	return rom;
+}
+
+void BenchROM::write(int kind, const std::string & fp)
+{
+	std::vector<byte> rom = build(kind);
+	std::unique_ptr<FILE, int(*)(FILE *)> file(fopen(fp.c_str(), "wb"), fclose);
+
+	if (!file || fwrite(rom.data(), rom.size(), 1, file.get()) != 1)
+		throw std::runtime_error("BenchROM::write(...), error! Cannot write " + fp);
+
+	mlibc_dbg("BenchROM::write(%s, %s)", getName(kind), fp.c_str());
+}
+
+}
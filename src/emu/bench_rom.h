@@ -0,0 +1,35 @@
+#ifndef BENCH_ROM_H
+#define BENCH_ROM_H
+
+#include <string>
+#include <vector>
+#include "data_types.h"
+
+namespace hgb
+{
+
+// Synthetic benchmark kernels, each loops forever from the cartridge entry point
+#define BENCH_ROM_ALU		0	// 8-bit ALU, CB rotates & relative jumps on registers only
+#define BENCH_ROM_MEMCPY	1	// 4KB ROM to WRAM copy through (HL+) & (DE)
+#define BENCH_ROM_CALL		2	// nested CALL / RET with PUSH & POP
+#define BENCH_ROM_HALT		3	// HALT waiting for VBlank every frame
+#define BENCH_ROM_BANK		4	// MBC1 ROM bank select writes & banked reads
+#define BENCH_ROM_IO		5	// LY, STAT, joypad & timer register polling
+#define BENCH_ROM_COUNT		6
+
+#define BENCH_ROM_SZ		0x8000	// 32KB, two banks
+
+// Generator for the benchmark cartridges, so throughput can be measured without game ROMs
+class BenchROM
+{
+public:
+	static const char * getName(int kind);
+	// Cartridge image with a valid header & checksums, runs with or without the boot ROM
+	static std::vector<byte> build(int kind);
+	// Throws if the file cannot be written
+	static void write(int kind, const std::string & fp);
+};
+
+}
+
+#endif // BENCH_ROM_H
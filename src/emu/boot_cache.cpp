@@ -0,0 +1,140 @@
+#include "boot_cache.h"
+#include <cinttypes>
+#include <cstdio>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include "3rdparty/mlibc_log.h"
+#include "emu/emulator.h"
+
+namespace hgb
+{
+
+BootCache::BootCache(
+	const std::string & directory
+) :
+	m_directory(directory),
+	m_lock(),
+	m_states()
+{
+	mlibc_dbg("BootCache::BootCache(directory:%s)", m_directory.c_str());
+}
+
+void BootCache::boot(Emulator & emu)
+{
+	uint64_t rom_hash = emu.getROMHash();
+	std::shared_ptr<const SaveState> state = find(rom_hash);
+
+	if (state)
+	{
+		emu.loadState(*state);
+		return;
+	}
+
+	if (!m_directory.empty())
+		state = read(rom_hash);
+
+	// Miss, run the boot ROM on a machine fresh from power on until it unmaps itself and jumps to the cartridge
+	if (!state)
+	{
+		Emulator fresh;
+		fresh.loadROM(emu.getROMPath());
+
+		int cycles = 0;
+		while (fresh.getMMU().getFF50() == 0x00 || fresh.getCPU().getRegisters().PC != 0x0100)
+		{
+			cycles += fresh.tick();
+
+			if (cycles > BOOT_CACHE_MAX_FRAMES * PPU_CYCLES_FRAME)
+				throw std::runtime_error("BootCache::boot(...), error! Boot ROM did not hand over to the cartridge!");
+		}
+
+		std::shared_ptr<SaveState> booted(new SaveState());
+		fresh.saveState(*booted);
+		state = booted;
+
+		if (!m_directory.empty())
+			write(rom_hash, *booted);
+
+		mlibc_dbg("BootCache::boot(...), booted ROM %016" PRIx64 " in %d cycles", rom_hash, cycles);
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		m_states[rom_hash] = state;
+	}
+
+	emu.loadState(*state);
+}
+
+void BootCache::clear()
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+	m_states.clear();
+}
+
+std::shared_ptr<const SaveState> BootCache::find(uint64_t rom_hash)
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+	auto it = m_states.find(rom_hash);
+
+	return (it != m_states.end()) ? it->second : nullptr;
+}
+
+std::shared_ptr<const SaveState> BootCache::read(uint64_t rom_hash)
+{
+	FILE * file_ptr = fopen(path(rom_hash).c_str(), "rb");
+
+	if (file_ptr == NULL)
+		return nullptr;
+
+	std::shared_ptr<SaveState> state(new SaveState());
+	size_t read = fread(state.get(), sizeof(SaveState), 1, file_ptr);
+	fclose(file_ptr);
+
+	// Stale or foreign files are rebuilt
+	if (read != 1 ||
+		state->magic != SAVESTATE_MAGIC ||
+		state->version != SAVESTATE_VERSION ||
+		state->size != sizeof(SaveState) ||
+		state->rom_hash != rom_hash)
+	{
+		mlibc_wrn("BootCache::read(...), warning! Ignoring incompatible %s", path(rom_hash).c_str());
+		return nullptr;
+	}
+
+	return state;
+}
+
+void BootCache::write(uint64_t rom_hash, const SaveState & state)
+{
+	// Write aside & rename, other processes never see a partial file
+	std::string fp = path(rom_hash);
+	std::string tmp = fp + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	FILE * file_ptr = fopen(tmp.c_str(), "wb");
+
+	if (file_ptr == NULL)
+	{
+		mlibc_wrn("BootCache::write(...), warning! Cannot write %s", tmp.c_str());
+		return;
+	}
+
+	size_t written = fwrite(&state, sizeof(SaveState), 1, file_ptr);
+	fclose(file_ptr);
+
+	if (written != 1 || std::rename(tmp.c_str(), fp.c_str()) != 0)
+	{
+		mlibc_wrn("BootCache::write(...), warning! Cannot write %s", fp.c_str());
+		std::remove(tmp.c_str());
+	}
+}
+
+std::string BootCache::path(uint64_t rom_hash)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016" PRIx64 BOOT_CACHE_EXT, rom_hash);
+
+	return m_directory + "/" + name;
+}
+
+}
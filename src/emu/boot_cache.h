@@ -0,0 +1,47 @@
+#ifndef BOOT_CACHE_H
+#define BOOT_CACHE_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "emu/savestate.h"
+
+namespace hgb
+{
+
+#define BOOT_CACHE_EXT			".hgbs"		// cached state file extension
+#define BOOT_CACHE_MAX_FRAMES	1200		// give up on a boot ROM that hasn't handed over by then
+
+class Emulator;
+
+// Machine states right after the boot ROM hands over to the cartridge at 0x0100, one per ROM.
+// Kept in memory and optionally in a directory, so the boot sequence runs once per ROM instead of once per reset.
+// Safe to share between threads.
+class BootCache
+{
+public:
+	// Empty directory keeps the cache in memory only
+	BootCache(
+		const std::string & directory = ""
+	);
+
+	// Put a machine with a ROM loaded into its post-boot state, works as a reset too. Runs the boot ROM once on a miss
+	void boot(Emulator & emu);
+	// Drop the in-memory states, files on disk stay
+	void clear();
+private:
+	std::shared_ptr<const SaveState> find(uint64_t rom_hash);
+	std::shared_ptr<const SaveState> read(uint64_t rom_hash);
+	void write(uint64_t rom_hash, const SaveState & state);
+	std::string path(uint64_t rom_hash);
+
+	std::string m_directory;
+	std::mutex m_lock;
+	std::map<uint64_t, std::shared_ptr<const SaveState>> m_states;
+};
+
+}
+
+#endif // BOOT_CACHE_H
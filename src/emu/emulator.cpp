@@ -0,0 +1,295 @@
+#include "emulator.h"
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include "3rdparty/mlibc_log.h"
+#include "util/hash.h"
+
+namespace hgb
+{
+
+// I/O registers as the DMG boot ROM leaves them, audio & serial are not emulated
+static const struct
+{
+	word addr;
+	byte value;
+} EMULATOR_POST_BOOT_IO[] =
+{
+	{ IO_REG_P1, 0xCF },
+	{ TIMER_REG_DIV, 0xAB },
+	{ TIMER_REG_TIMA, 0x00 },
+	{ TIMER_REG_TMA, 0x00 },
+	{ TIMER_REG_TAC, 0xF8 },
+	{ IRQ_REG_IF, 0xE1 },
+	{ PPU_REG_SCY, 0x00 },
+	{ PPU_REG_SCX, 0x00 },
+	{ PPU_REG_LYC, 0x00 },
+	{ PPU_REG_BGP, 0xFC },
+	{ PPU_REG_OBP0, 0xFF },
+	{ PPU_REG_OBP1, 0xFF },
+	{ PPU_REG_WY, 0x00 },
+	{ PPU_REG_WX, 0x00 },
+	{ IRQ_REG_IE, 0x00 },
+	// LCD on last, it starts a new frame
+	{ PPU_REG_LCDC, 0x91 },
+	{ MMU_REG_BOOT, 0x01 }
+};
+
+Emulator::Emulator() :
+	m_irq(),
+	m_joy(),
+	m_timer(),
+	m_ppu(m_irq),
+	m_mmu(m_irq, m_joy, m_timer, m_ppu),
+	m_cpu(m_mmu),
+	m_rom_path(),
+	m_rom_hash(0),
+	m_frame_timer(nullptr)
+{
+	mlibc_dbg("Emulator::Emulator()");
+}
+
+Emulator::~Emulator()
+{
+	mlibc_dbg("Emulator::~Emulator()");
+}
+
+void Emulator::loadROM(const std::string & fp)
+{
+	m_mmu.loadROM(fp);
+	m_rom_path = fp;
+	m_rom_hash = fnv1a(m_mmu.getCart()->data, m_mmu.getCart()->data_len);
+}
+
+void Emulator::skipBootROM()
+{
+	// Cartridge logo at 0x8010, every bit becomes 2x2 pixels
+	word addr = 0x8010;
+	for (word i = 0x0104; i < 0x0134; i++)
+	{
+		byte logo = m_mmu.read(i);
+
+		for (int shift = 4; shift >= 0; shift -= 4)
+		{
+			byte pixels = 0x00;
+			for (int bit = 0; bit < 4; bit++)
+			{
+				if (logo & (1 << (shift + bit)))
+					pixels |= 0x03 << (bit * 2);
+			}
+
+			m_mmu.write(addr, pixels);
+			m_mmu.write(addr + 2, pixels);
+			addr += 4;
+		}
+	}
+
+	// (R) symbol from the boot ROM right after it
+	byte trademark[8];
+	m_mmu.getBootROM()->peek(0x00D8, trademark, sizeof(trademark));
+	for (int i = 0; i < 8; i++)
+	{
+		m_mmu.write(0x8190 + i * 2, trademark[i]);
+	}
+
+	// Logo tiles 0x01-0x18 in two rows, (R) at the end of the first one
+	for (int i = 0; i < 12; i++)
+	{
+		m_mmu.write(0x9904 + i, static_cast<byte>(0x01 + i));
+		m_mmu.write(0x9924 + i, static_cast<byte>(0x0D + i));
+	}
+	m_mmu.write(0x9910, 0x19);
+
+	for (const auto & reg : EMULATOR_POST_BOOT_IO)
+	{
+		m_mmu.write(reg.addr, reg.value);
+	}
+
+	CPURegisters & registers = m_cpu.getRegisters();
+	registers.AF = 0x01B0;
+	registers.BC = 0x0013;
+	registers.DE = 0x00D8;
+	registers.HL = 0x014D;
+	registers.SP = 0xFFFE;
+	registers.PC = 0x0100;
+
+	mlibc_dbg("Emulator::skipBootROM()");
+}
+
+int Emulator::tick()
+{
+	int64_t clock = m_cpu.getState().CLOCK;
+	m_cpu.tick();
+
+	int cycles = static_cast<int>(m_cpu.getState().CLOCK - clock);
+	m_ppu.tick(cycles);
+
+	return cycles;
+}
+
+int Emulator::runFrame()
+{
+	FrameTimerScope scope(m_frame_timer, FRAME_TIMER_EMULATE);
+	unsigned frame = m_ppu.getFrame();
+	int cycles = 0;
+
+	while (m_ppu.getFrame() == frame && cycles < PPU_CYCLES_FRAME)
+	{
+		cycles += tick();
+	}
+
+	return cycles;
+}
+
+void Emulator::saveState(SaveState & state)
+{
+	state.magic = SAVESTATE_MAGIC;
+	state.version = SAVESTATE_VERSION;
+	state.size = sizeof(SaveState);
+	state.rom_hash = m_rom_hash;
+	state.cpu_registers = m_cpu.getRegisters();
+	state.cpu_state = m_cpu.getState();
+	m_irq.saveState(state.irq);
+	m_joy.saveState(state.joypad);
+	m_timer.saveState(state.timer);
+	m_mmu.saveState(state.mmu);
+	m_ppu.saveState(state.ppu);
+}
+
+void Emulator::loadState(const SaveState & state)
+{
+	if (state.magic != SAVESTATE_MAGIC || state.version != SAVESTATE_VERSION || state.size != sizeof(SaveState))
+		throw std::runtime_error("Emulator::loadState(...), error! Incompatible savestate version!");
+
+	if (state.rom_hash != m_rom_hash)
+		throw std::runtime_error("Emulator::loadState(...), error! Savestate belongs to another ROM!");
+
+	m_cpu.getRegisters() = state.cpu_registers;
+	m_cpu.getState() = state.cpu_state;
+	m_irq.loadState(state.irq);
+	m_joy.loadState(state.joypad);
+	m_timer.loadState(state.timer);
+	m_mmu.loadState(state.mmu);
+	m_ppu.loadState(state.ppu);
+}
+
+void Emulator::saveStateFile(const std::string & fp)
+{
+	std::unique_ptr<SaveState> state(new SaveState());
+	saveState(*state);
+
+	FILE * file_ptr = fopen(fp.c_str(), "wb");
+
+	if (file_ptr == NULL)
+		throw std::runtime_error("Emulator::saveStateFile(...), error! fopen returned a NULL pointer!");
+
+	size_t written = fwrite(state.get(), sizeof(SaveState), 1, file_ptr);
+	fclose(file_ptr);
+
+	if (written != 1)
+		throw std::runtime_error("Emulator::saveStateFile(...), error! Short write!");
+
+	mlibc_dbg("Emulator::saveStateFile(%s)", fp.c_str());
+}
+
+void Emulator::loadStateFile(const std::string & fp)
+{
+	std::unique_ptr<SaveState> state(new SaveState());
+
+	FILE * file_ptr = fopen(fp.c_str(), "rb");
+
+	if (file_ptr == NULL)
+		throw std::runtime_error("Emulator::loadStateFile(...), error! fopen returned a NULL pointer!");
+
+	size_t read = fread(state.get(), sizeof(SaveState), 1, file_ptr);
+	fclose(file_ptr);
+
+	if (read != 1)
+		throw std::runtime_error("Emulator::loadStateFile(...), error! File is too short for a savestate!");
+
+	loadState(*state);
+
+	mlibc_dbg("Emulator::loadStateFile(%s)", fp.c_str());
+}
+
+void Emulator::copyFrom(Emulator & other)
+{
+	// Small register blocks go through their savestate images
+	IRQState irq;
+	JoypadState joy;
+	TimerState timer;
+	other.m_irq.saveState(irq);
+	other.m_joy.saveState(joy);
+	other.m_timer.saveState(timer);
+	m_irq.loadState(irq);
+	m_joy.loadState(joy);
+	m_timer.loadState(timer);
+
+	m_mmu.share(other.m_mmu);
+	m_ppu.copyFrom(other.m_ppu);
+	m_cpu.getRegisters() = other.m_cpu.getRegisters();
+	m_cpu.getState() = other.m_cpu.getState();
+	m_rom_path = other.m_rom_path;
+	m_rom_hash = other.m_rom_hash;
+}
+
+std::unique_ptr<Emulator> Emulator::clone()
+{
+	std::unique_ptr<Emulator> emu(new Emulator());
+	emu->copyFrom(*this);
+
+	return emu;
+}
+
+IRQ & Emulator::getIRQ()
+{
+	return m_irq;
+}
+
+Joypad & Emulator::getJoypad()
+{
+	return m_joy;
+}
+
+Timer & Emulator::getTimer()
+{
+	return m_timer;
+}
+
+PPU & Emulator::getPPU()
+{
+	return m_ppu;
+}
+
+MMU & Emulator::getMMU()
+{
+	return m_mmu;
+}
+
+CPU & Emulator::getCPU()
+{
+	return m_cpu;
+}
+
+const std::string & Emulator::getROMPath()
+{
+	return m_rom_path;
+}
+
+uint64_t Emulator::getROMHash()
+{
+	return m_rom_hash;
+}
+
+void Emulator::setFrameTimer(FrameTimer * frame_timer)
+{
+	m_frame_timer = frame_timer;
+	m_ppu.setFrameTimer(frame_timer);
+}
+
+FrameTimer * Emulator::getFrameTimer()
+{
+	return m_frame_timer;
+}
+
+}
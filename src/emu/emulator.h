@@ -0,0 +1,78 @@
+#ifndef EMULATOR_H
+#define EMULATOR_H
+
+#include <memory>
+#include <string>
+#include "cpu/irq.h"
+#include "io/joypad.h"
+#include "io/timer.h"
+#include "ppu/ppu.h"
+#include "mem/mmu.h"
+#include "cpu/cpu.h"
+#include "util/frame_timer.h"
+#include "emu/savestate.h"
+
+namespace hgb
+{
+
+// One complete DMG machine. Instances share no mutable state, any number of them may run on separate threads.
+// The only process wide object is the mlibc_log instance, which is read-only once initialized.
+class Emulator
+{
+public:
+	Emulator();
+	~Emulator();
+
+	Emulator(const Emulator &) = delete;
+	Emulator & operator=(const Emulator &) = delete;
+
+	// Load a ROM file
+	void loadROM(const std::string & fp);
+	// Start at the cartridge entry point with the registers, VRAM logo & FF50 as the DMG boot ROM leaves them,
+	// instead of running ~2.5 seconds of boot ROM. Call right after loadROM()
+	void skipBootROM();
+	// Run one CPU instruction and clock the PPU alongside, returns cycles taken
+	int tick();
+	// Run until the PPU completes a frame, or a frame worth of cycles with the LCD off, returns cycles taken
+	int runFrame();
+
+	// Snapshot the whole machine, takes a few microseconds
+	void saveState(SaveState & state);
+	// Restore a snapshot taken from the same ROM, throws on version or ROM mismatch
+	void loadState(const SaveState & state);
+	void saveStateFile(const std::string & fp);
+	void loadStateFile(const std::string & fp);
+	// Become an exact copy of another machine. ROM is shared, RAM pages are shared until either side writes them,
+	// VRAM, OAM & framebuffers are small enough to be copied outright. Reusing instances skips the construction cost
+	void copyFrom(Emulator & other);
+	// New machine in the exact same state, see copyFrom()
+	std::unique_ptr<Emulator> clone();
+
+	IRQ & getIRQ();
+	Joypad & getJoypad();
+	Timer & getTimer();
+	PPU & getPPU();
+	MMU & getMMU();
+	CPU & getCPU();
+	// Path & FNV-1a of the loaded ROM file
+	const std::string & getROMPath();
+	uint64_t getROMHash();
+	// Time frames & PPU rendering into timer, NULL turns timing off. Host setting, not part of the machine state
+	void setFrameTimer(FrameTimer * frame_timer);
+	FrameTimer * getFrameTimer();
+private:
+	// Construction order matters, the MMU and CPU reference the devices above them
+	IRQ m_irq;
+	Joypad m_joy;
+	Timer m_timer;
+	PPU m_ppu;
+	MMU m_mmu;
+	CPU m_cpu;
+	std::string m_rom_path;
+	uint64_t m_rom_hash;
+	FrameTimer * m_frame_timer;
+};
+
+}
+
+#endif // EMULATOR_H
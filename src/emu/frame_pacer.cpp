@@ -0,0 +1,109 @@
+#include "frame_pacer.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include "3rdparty/mlibc_log.h"
+
+namespace hgb
+{
+
+FramePacer::FramePacer() :
+	m_mode(NORMAL),
+	m_period(),
+	m_deadline(clock::now()),
+	m_frames(0),
+	m_late(0),
+	m_error_sum(0.0),
+	m_error_sq_sum(0.0),
+	m_error_max(0.0)
+{
+	setMode(NORMAL);
+
+	mlibc_dbg("FramePacer::FramePacer()");
+}
+
+void FramePacer::setMode(Mode_t mode, int multiplier)
+{
+	m_mode = mode;
+
+	if (m_mode == NORMAL)
+		multiplier = 1;
+
+	multiplier = std::max(multiplier, 1);
+	m_period = std::chrono::duration_cast<clock::duration>(
+		std::chrono::duration<double>(1.0 / (FRAME_PACER_HZ * multiplier))
+	);
+
+	// Start pacing from now on, don't try to catch up with time spent in another mode
+	m_deadline = clock::now();
+
+	mlibc_dbg("FramePacer::setMode(mode:%d, multiplier:%d)", m_mode, multiplier);
+}
+
+FramePacer::Mode_t FramePacer::getMode()
+{
+	return m_mode;
+}
+
+void FramePacer::wait()
+{
+	if (m_mode == TURBO)
+		return;
+
+	m_deadline += m_period;
+
+	// Sleep the bulk of the wait, the OS scheduler overshoots by up to a few milliseconds
+	clock::duration spin = std::chrono::microseconds(FRAME_PACER_SPIN_US);
+	clock::time_point now = clock::now();
+
+	if (m_deadline - now > spin)
+		std::this_thread::sleep_for(m_deadline - now - spin);
+
+	// Spin out the rest for an exact wake-up
+	while ((now = clock::now()) < m_deadline)
+	{
+		std::this_thread::yield();
+	}
+
+	// Jitter statistics
+	double error = std::chrono::duration<double, std::micro>(now - m_deadline).count();
+	m_frames++;
+	m_error_sum += error;
+	m_error_sq_sum += error * error;
+	m_error_max = std::max(m_error_max, error);
+
+	// More than a frame behind (breakpoint, host stall), drop the debt instead of fast-forwarding
+	if (now - m_deadline > m_period)
+	{
+		m_late++;
+		m_deadline = now;
+	}
+}
+
+FramePacerStats FramePacer::getStats()
+{
+	FramePacerStats stats = {};
+
+	stats.frames = m_frames;
+	stats.late = m_late;
+
+	if (m_frames > 0)
+	{
+		stats.mean_us = m_error_sum / m_frames;
+		stats.stddev_us = std::sqrt(std::max(m_error_sq_sum / m_frames - stats.mean_us * stats.mean_us, 0.0));
+		stats.max_us = m_error_max;
+	}
+
+	return stats;
+}
+
+void FramePacer::resetStats()
+{
+	m_frames = 0;
+	m_late = 0;
+	m_error_sum = 0.0;
+	m_error_sq_sum = 0.0;
+	m_error_max = 0.0;
+}
+
+}
\ No newline at end of file
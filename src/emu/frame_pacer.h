@@ -0,0 +1,61 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <chrono>
+#include <cstdint>
+
+namespace hgb
+{
+
+// DMG frame rate, 4194304 Hz / 70224 cycles per frame
+#define FRAME_PACER_HZ			59.727500569606
+// Sleep until this close to the deadline, spin the rest
+#define FRAME_PACER_SPIN_US		1500
+
+struct FramePacerStats
+{
+	// # of paced frames
+	uint64_t frames;
+	// Frames that fell more than a frame behind and dropped the debt
+	uint64_t late;
+	// Wake-up error against the deadline in microseconds
+	double mean_us;
+	double stddev_us;
+	double max_us;
+};
+
+class FramePacer
+{
+public:
+	enum Mode_t
+	{
+		NORMAL = 0,		// real DMG speed
+		MULTIPLIER = 1,	// fixed multiple of DMG speed
+		TURBO = 2		// unthrottled
+	};
+
+	FramePacer();
+
+	void setMode(Mode_t mode, int multiplier = 1);
+	Mode_t getMode();
+	// Call once per emulated frame, returns when the next frame is due
+	void wait();
+
+	FramePacerStats getStats();
+	void resetStats();
+private:
+	typedef std::chrono::steady_clock clock;
+
+	Mode_t m_mode;
+	clock::duration m_period;
+	clock::time_point m_deadline;
+	uint64_t m_frames;
+	uint64_t m_late;
+	double m_error_sum;
+	double m_error_sq_sum;
+	double m_error_max;
+};
+
+}
+
+#endif // FRAME_PACER_H
\ No newline at end of file
@@ -0,0 +1,226 @@
+#include "rewind.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include "3rdparty/mlibc_log.h"
+#include "emu/emulator.h"
+
+namespace hgb
+{
+
+static inline uint64_t load64(const byte * src)
+{
+	uint64_t value;
+	std::memcpy(&value, src, sizeof(value));
+	return value;
+}
+
+static inline byte * writeVarint(byte * dst, size_t value)
+{
+	while (value >= 0x80)
+	{
+		*dst++ = static_cast<byte>(value | 0x80);
+		value >>= 7;
+	}
+	*dst++ = static_cast<byte>(value);
+
+	return dst;
+}
+
+static inline const byte * readVarint(const byte * src, size_t & value)
+{
+	value = 0;
+	for (int shift = 0; ; shift += 7)
+	{
+		byte b = *src++;
+		value |= static_cast<size_t>(b & 0x7F) << shift;
+
+		if ((b & 0x80) == 0)
+			break;
+	}
+
+	return src;
+}
+
+Rewind::Rewind(
+	size_t size,
+	int interval
+) :
+	m_ring(new byte[size]),
+	m_ring_size(size),
+	m_interval(std::max(interval, 1)),
+	m_frames(0),
+	m_valid(false),
+	m_current(new SaveState()),
+	m_next(new SaveState()),
+	m_scratch(new byte[sizeof(SaveState) * 2 + 64]),
+	m_deltas(),
+	m_head(0),
+	m_used(0)
+{
+	mlibc_dbg("Rewind::Rewind(size:%zu, interval:%d)", m_ring_size, m_interval);
+}
+
+void Rewind::capture(Emulator & emu)
+{
+	if (++m_frames < m_interval)
+		return;
+
+	m_frames = 0;
+
+	// First snapshot has nothing to diff against
+	if (!m_valid)
+	{
+		emu.saveState(*m_current);
+		m_valid = true;
+		return;
+	}
+
+	// Store what turns the new snapshot back into the current one, then the new one becomes current
+	emu.saveState(*m_next);
+
+	size_t size = encode(
+		reinterpret_cast<const byte *>(m_next.get()),
+		reinterpret_cast<const byte *>(m_current.get()),
+		sizeof(SaveState),
+		m_scratch.get()
+	);
+	push(m_scratch.get(), size);
+
+	std::swap(m_current, m_next);
+}
+
+bool Rewind::rewind(Emulator & emu)
+{
+	if (!m_valid)
+		return false;
+
+	bool stepped = false;
+
+	if (!m_deltas.empty())
+	{
+		Delta delta = m_deltas.back();
+		m_deltas.pop_back();
+
+		apply(reinterpret_cast<byte *>(m_current.get()), &m_ring[delta.offset], delta.size);
+
+		// The newest delta is always right below the head
+		m_head = delta.offset;
+		m_used -= delta.size;
+		stepped = true;
+	}
+
+	emu.loadState(*m_current);
+	m_frames = 0;
+
+	return stepped;
+}
+
+void Rewind::clear()
+{
+	m_deltas.clear();
+	m_valid = false;
+	m_frames = 0;
+	m_head = 0;
+	m_used = 0;
+}
+
+size_t Rewind::getCount()
+{
+	return (m_valid) ? m_deltas.size() + 1 : 0;
+}
+
+size_t Rewind::getUsed()
+{
+	return m_used;
+}
+
+size_t Rewind::encode(const byte * a, const byte * b, size_t size, byte * dst)
+{
+	byte * out = dst;
+	size_t i = 0;
+
+	// Pairs of <# of equal bytes> <# of literals> followed by the XORed literals
+	while (i < size)
+	{
+		size_t start = i;
+		while (i + 8 <= size && load64(a + i) == load64(b + i))
+			i += 8;
+		while (i < size && a[i] == b[i])
+			i++;
+
+		out = writeVarint(out, i - start);
+
+		// Literals until the next 8 equal bytes
+		start = i;
+		while (i < size && !(i + 8 <= size && load64(a + i) == load64(b + i)))
+			i++;
+
+		out = writeVarint(out, i - start);
+		for (size_t j = start; j < i; j++)
+		{
+			*out++ = a[j] ^ b[j];
+		}
+	}
+
+	return static_cast<size_t>(out - dst);
+}
+
+void Rewind::apply(byte * dst, const byte * src, size_t size)
+{
+	const byte * end = src + size;
+	size_t i = 0;
+
+	while (src < end)
+	{
+		size_t equal, literals;
+		src = readVarint(src, equal);
+		src = readVarint(src, literals);
+
+		i += equal;
+		for (size_t j = 0; j < literals; j++)
+		{
+			dst[i++] ^= *src++;
+		}
+	}
+}
+
+void Rewind::push(const byte * delta, size_t size)
+{
+	// Doesn't fit at all, the history restarts from the current snapshot
+	if (size > m_ring_size)
+	{
+		m_deltas.clear();
+		m_head = 0;
+		m_used = 0;
+		return;
+	}
+
+	// Wrap around, everything past the head is older than what sits below it
+	if (m_head + size > m_ring_size)
+	{
+		while (!m_deltas.empty() && m_deltas.front().offset >= m_head)
+		{
+			m_used -= m_deltas.front().size;
+			m_deltas.pop_front();
+		}
+
+		m_head = 0;
+	}
+
+	// Drop the oldest deltas in the way
+	while (!m_deltas.empty() &&
+		   m_deltas.front().offset < m_head + size &&
+		   m_deltas.front().offset + m_deltas.front().size > m_head)
+	{
+		m_used -= m_deltas.front().size;
+		m_deltas.pop_front();
+	}
+
+	std::memcpy(&m_ring[m_head], delta, size);
+	m_deltas.push_back({ m_head, size });
+	m_head += size;
+	m_used += size;
+}
+
+}
@@ -0,0 +1,72 @@
+#ifndef REWIND_H
+#define REWIND_H
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include "data_types.h"
+#include "emu/savestate.h"
+
+namespace hgb
+{
+
+#define REWIND_SZ			(8 * 1024 * 1024)	// default history size in bytes
+#define REWIND_INTERVAL		4					// default # of frames between snapshots
+
+class Emulator;
+
+// Rewind history in a fixed-size ring. Only the newest snapshot is kept whole,
+// older ones are stored as run-length encoded XOR deltas against their successor, so unchanged memory costs next to nothing.
+// The oldest deltas are dropped when the ring runs out of space.
+class Rewind
+{
+public:
+	Rewind(
+		size_t size = REWIND_SZ,
+		int interval = REWIND_INTERVAL
+	);
+
+	// Call once per emulated frame, takes a snapshot every interval:th call
+	void capture(Emulator & emu);
+	// Step back to the previous snapshot and load it, returns false once the oldest one is reached (it is loaded still)
+	bool rewind(Emulator & emu);
+	// Forget the whole history
+	void clear();
+
+	// # of snapshots in the history, the newest included
+	size_t getCount();
+	// Bytes of the ring in use
+	size_t getUsed();
+private:
+	struct Delta
+	{
+		size_t offset;
+		size_t size;
+	};
+
+	// Run-length encode a ^ b, returns the encoded size
+	static size_t encode(const byte * a, const byte * b, size_t size, byte * dst);
+	// XOR an encoded delta into dst
+	static void apply(byte * dst, const byte * src, size_t size);
+
+	void push(const byte * delta, size_t size);
+
+	std::unique_ptr<byte[]> m_ring;
+	size_t m_ring_size;
+	int m_interval;
+	int m_frames;
+	bool m_valid;
+	// Newest snapshot & the one being captured
+	std::unique_ptr<SaveState> m_current;
+	std::unique_ptr<SaveState> m_next;
+	// Encoder output, worst case size
+	std::unique_ptr<byte[]> m_scratch;
+	// Oldest first
+	std::deque<Delta> m_deltas;
+	size_t m_head;
+	size_t m_used;
+};
+
+}
+
+#endif // REWIND_H
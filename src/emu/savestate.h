@@ -0,0 +1,39 @@
+#ifndef SAVESTATE_H
+#define SAVESTATE_H
+
+#include <cstdint>
+#include "cpu/cpu_registers.h"
+#include "cpu/cpu_state.h"
+#include "cpu/irq.h"
+#include "io/joypad.h"
+#include "io/timer.h"
+#include "mem/mmu.h"
+#include "ppu/ppu.h"
+
+namespace hgb
+{
+
+#define SAVESTATE_MAGIC		0x54534748	// "HGST"
+#define SAVESTATE_VERSION	2			// bump on any layout change
+
+// Whole machine as one flat block, saved & loaded with plain copies and no allocation.
+// The layout is the in-memory one, states move between builds of the same version on the same platform.
+struct SaveState
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t size;
+	// FNV-1a of the ROM the state was taken from, loading into another ROM is refused
+	uint64_t rom_hash;
+	CPURegisters cpu_registers;
+	CPUState cpu_state;
+	IRQState irq;
+	JoypadState joypad;
+	TimerState timer;
+	MMUState mmu;
+	PPUState ppu;
+};
+
+}
+
+#endif // SAVESTATE_H
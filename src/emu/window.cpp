@@ -1,16 +1,169 @@
 #include "window.h"
+#include <algorithm>
 #include <SDL2/SDL.h>
 #include "3rdparty/mlibc_log.h"
 
+// SSE2 is part of every x86-64 target, 32-bit x86 needs it enabled explicitly
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WINDOW_SSE2 1
+#include <emmintrin.h>
+#else
+#define WINDOW_SSE2 0
+#endif
+
 namespace Window
 {
 
+static void blit_shade2(int32_t * dst, const uint8_t * src, int n, const int32_t * palette)
+{
+	int i = 0;
+
+#if WINDOW_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i p0 = _mm_set1_epi32(palette[0]);
+	const __m128i p1 = _mm_set1_epi32(palette[1]);
+	const __m128i p2 = _mm_set1_epi32(palette[2]);
+	const __m128i p3 = _mm_set1_epi32(palette[3]);
+	const __m128i k1 = _mm_set1_epi32(1);
+	const __m128i k2 = _mm_set1_epi32(2);
+	const __m128i k3 = _mm_set1_epi32(3);
+	const __m128i k3b = _mm_set1_epi8(3);
+
+	// 16 pixels per pass, widen bytes to 32-bit lanes and select the palette entry by compare
+	for (; i + 16 <= n; i += 16)
+	{
+		__m128i v = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)), k3b);
+		__m128i lo = _mm_unpacklo_epi8(v, zero);
+		__m128i hi = _mm_unpackhi_epi8(v, zero);
+		__m128i d[4] = {
+			_mm_unpacklo_epi16(lo, zero),
+			_mm_unpackhi_epi16(lo, zero),
+			_mm_unpacklo_epi16(hi, zero),
+			_mm_unpackhi_epi16(hi, zero)
+		};
+
+		for (int j = 0; j < 4; j++)
+		{
+			__m128i out = _mm_and_si128(_mm_cmpeq_epi32(d[j], zero), p0);
+			out = _mm_or_si128(out, _mm_and_si128(_mm_cmpeq_epi32(d[j], k1), p1));
+			out = _mm_or_si128(out, _mm_and_si128(_mm_cmpeq_epi32(d[j], k2), p2));
+			out = _mm_or_si128(out, _mm_and_si128(_mm_cmpeq_epi32(d[j], k3), p3));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + j * 4), out);
+		}
+	}
+#endif
+
+	for (; i < n; i++)
+		dst[i] = palette[src[i] & 0x03];
+}
+
+static void blit_indexed8(int32_t * dst, const uint8_t * src, int n, const int32_t * palette)
+{
+	// No gather in SSE2, a table lookup per pixel is as good as it gets
+	int i = 0;
+
+	for (; i + 4 <= n; i += 4)
+	{
+		dst[i + 0] = palette[src[i + 0]];
+		dst[i + 1] = palette[src[i + 1]];
+		dst[i + 2] = palette[src[i + 2]];
+		dst[i + 3] = palette[src[i + 3]];
+	}
+
+	for (; i < n; i++)
+		dst[i] = palette[src[i]];
+}
+
+static inline int32_t rgb555(uint16_t c)
+{
+	uint32_t r = c & 0x1F, g = (c >> 5) & 0x1F, b = (c >> 10) & 0x1F;
+
+	// Widen 5-bit channels to 8 bits by replicating the top bits
+	r = (r << 3) | (r >> 2);
+	g = (g << 3) | (g >> 2);
+	b = (b << 3) | (b >> 2);
+
+	return static_cast<int32_t>(0xFF000000 | (r << 16) | (g << 8) | b);
+}
+
+static void blit_rgb555(int32_t * dst, const uint16_t * src, int n)
+{
+	int i = 0;
+
+#if WINDOW_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i mask = _mm_set1_epi32(0x1F);
+	const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+
+	// 8 pixels per pass
+	for (; i + 8 <= n; i += 8)
+	{
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+		__m128i d[2] = {
+			_mm_unpacklo_epi16(v, zero),
+			_mm_unpackhi_epi16(v, zero)
+		};
+
+		for (int j = 0; j < 2; j++)
+		{
+			__m128i r = _mm_and_si128(d[j], mask);
+			__m128i g = _mm_and_si128(_mm_srli_epi32(d[j], 5), mask);
+			__m128i b = _mm_and_si128(_mm_srli_epi32(d[j], 10), mask);
+
+			r = _mm_or_si128(_mm_slli_epi32(r, 3), _mm_srli_epi32(r, 2));
+			g = _mm_or_si128(_mm_slli_epi32(g, 3), _mm_srli_epi32(g, 2));
+			b = _mm_or_si128(_mm_slli_epi32(b, 3), _mm_srli_epi32(b, 2));
+
+			__m128i out = _mm_or_si128(alpha, _mm_slli_epi32(r, 16));
+			out = _mm_or_si128(out, _mm_slli_epi32(g, 8));
+			out = _mm_or_si128(out, b);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + j * 4), out);
+		}
+	}
+#endif
+
+	for (; i < n; i++)
+		dst[i] = rgb555(src[i]);
+}
+
+static bool lock(Window * w)
+{
+	void * pixels = nullptr;
+	int pitch = 0;
+
+	if (SDL_LockTexture(w->texture, NULL, &pixels, &pitch) != 0)
+	{
+		w->framebuffer = nullptr;
+		return false;
+	}
+
+	w->framebuffer = static_cast<int32_t *>(pixels);
+	w->stride = pitch / static_cast<int>(sizeof(int32_t));
+
+	return true;
+}
+
+static void invalidate(Window * w, int y, int rows)
+{
+	if (w->dirty_bottom <= w->dirty_top)
+	{
+		w->dirty_top = y;
+		w->dirty_bottom = y + rows;
+	}
+	else
+	{
+		w->dirty_top = std::min(w->dirty_top, y);
+		w->dirty_bottom = std::max(w->dirty_bottom, y + rows);
+	}
+}
+
 Window * create(
 	const std::string & title,
 	int width,
 	int height,
 	int scale,
-	bool fullscreen
+	bool fullscreen,
+	bool retained
 )
 {
 	Window * window = new Window;
@@ -19,6 +172,9 @@ Window * create(
 	window->width = width;
 	window->height = height;
 	window->scale = scale;
+	window->retained = retained;
+	window->dirty_top = 0;
+	window->dirty_bottom = height;
 	window->handle = SDL_CreateWindow(
 		title.c_str(),
 		SDL_WINDOWPOS_CENTERED,
@@ -52,7 +208,7 @@ Window * create(
 	window->texture = SDL_CreateTexture(
 		window->renderer,
 		SDL_PIXELFORMAT_ARGB8888,
-		SDL_TEXTUREACCESS_STATIC,
+		SDL_TEXTUREACCESS_STREAMING,
 		width,
 		height
 	);
@@ -66,14 +222,22 @@ Window * create(
 		return nullptr;
 	}
 
-	window->framebuffer = new int32_t[width * height];
-	if (window->framebuffer == nullptr)
+	// Framebuffer contents are opaque, alpha is not used
+	SDL_SetTextureBlendMode(window->texture, SDL_BLENDMODE_NONE);
+
+	// Retained windows keep the image between frames, the rest draw straight into texture memory
+	if (retained)
+	{
+		window->framebuffer = new int32_t[width * height]();
+		window->stride = width;
+	}
+	else if (lock(window) == false)
 	{
 		SDL_DestroyTexture(window->texture);
 		SDL_DestroyRenderer(window->renderer);
 		SDL_DestroyWindow(window->handle);
 		delete window;
-		mlibc_err("Window::create(%s). Error allocating a new framebuffer object!", title.c_str());
+		mlibc_err("Window::create(%s). Error locking the SDL_Texture instance!", title.c_str());
 		return nullptr;
 	}
 
@@ -84,7 +248,10 @@ Window * create(
 
 void free(Window * w)
 {
-	delete w->framebuffer;
+	if (w->retained)
+		delete[] w->framebuffer;
+	else if (w->framebuffer != nullptr)
+		SDL_UnlockTexture(w->texture);
 	SDL_DestroyTexture(w->texture);
 	SDL_DestroyRenderer(w->renderer);
 	SDL_DestroyWindow(w->handle);
@@ -95,23 +262,44 @@ void free(Window * w)
 
 void render(Window * w)
 {
-	SDL_UpdateTexture(
-		w->texture,
-		NULL,
-		w->framebuffer,
-		w->width * sizeof(int32_t)
-	);
+	if (w->retained)
+	{
+		// Upload the rows drawn since the last render, the texture keeps the rest
+		if (w->dirty_bottom > w->dirty_top)
+		{
+			SDL_Rect rect = { 0, w->dirty_top, w->width, w->dirty_bottom - w->dirty_top };
+			SDL_UpdateTexture(w->texture, &rect, w->framebuffer + w->dirty_top * w->stride, w->stride * static_cast<int>(sizeof(int32_t)));
+		}
+	}
+	else if (w->framebuffer != nullptr)
+	{
+		SDL_UnlockTexture(w->texture);
+	}
+
+	w->dirty_top = w->dirty_bottom = 0;
+
 	SDL_RenderClear(w->renderer);
 	SDL_RenderCopy(w->renderer, w->texture, NULL, NULL);
 	SDL_RenderPresent(w->renderer);
+
+	if (!w->retained && lock(w) == false)
+		mlibc_err("Window::render(%s). Error locking the SDL_Texture instance!", w->title.c_str());
 }
 
 void clear(Window * w, const int32_t argb)
 {
-	size_t resolution = static_cast<size_t>(w->width * w->height);
+	if (w->framebuffer == nullptr)
+		return;
+
+	invalidate(w, 0, w->height);
 
-	for (size_t i = 0; i < resolution; i++)
-		w->framebuffer[i] = argb;
+	for (int y = 0; y < w->height; y++)
+	{
+		int32_t * row = w->framebuffer + y * w->stride;
+
+		for (int x = 0; x < w->width; x++)
+			row[x] = argb;
+	}
 }
 
 void set_pixel(
@@ -122,11 +310,51 @@ void set_pixel(
 	uint8_t b
 )
 {
-	if (i < 0 || i >= w->width * w->height)
+	if (i < 0 || i >= w->width * w->height || w->framebuffer == nullptr)
 		return;
 
-	w->framebuffer[i] = ((r << 16) | (g << 8) | b);
+	invalidate(w, i / w->width, 1);
+	w->framebuffer[(i / w->width) * w->stride + i % w->width] = ((r << 16) | (g << 8) | b);
 }
 
+void blit(
+	Window * w,
+	const void * src,
+	Format format,
+	const int32_t * palette,
+	int y,
+	int rows
+)
+{
+	if (w->framebuffer == nullptr || y < 0 || y >= w->height)
+		return;
+
+	if (rows < 0 || y + rows > w->height)
+		rows = w->height - y;
+
+	invalidate(w, y, rows);
+
+	for (int row = y; row < y + rows; row++)
+	{
+		int32_t * dst = w->framebuffer + row * w->stride;
+		size_t offset = static_cast<size_t>(row) * w->width;
+
+		switch (format)
+		{
+			case FORMAT_SHADE2:
+			{
+				blit_shade2(dst, static_cast<const uint8_t *>(src) + offset, w->width, palette);
+			} break;
+			case FORMAT_INDEXED8:
+			{
+				blit_indexed8(dst, static_cast<const uint8_t *>(src) + offset, w->width, palette);
+			} break;
+			case FORMAT_RGB555:
+			{
+				blit_rgb555(dst, static_cast<const uint16_t *>(src) + offset, w->width);
+			} break;
+		}
+	}
 }
 
+}
\ No newline at end of file
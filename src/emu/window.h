@@ -2,6 +2,7 @@
 #define WINDOW_H
 
 #include <string>
+#include <cstdint>
 
 typedef struct SDL_Window SDL_Window;
 typedef struct SDL_Renderer SDL_Renderer;
@@ -10,6 +11,14 @@ typedef struct SDL_Texture SDL_Texture;
 namespace Window
 {
 
+// Source pixel formats accepted by blit()
+enum Format
+{
+	FORMAT_SHADE2 = 0,		// 1 byte per pixel, shade 0-3 through a 4 entry palette
+	FORMAT_INDEXED8 = 1,	// 1 byte per pixel through a 256 entry palette
+	FORMAT_RGB555 = 2		// 2 bytes per pixel, 0bxBBBBBGGGGGRRRRR, no palette
+};
+
 struct Window
 {
 	std::string title;
@@ -17,7 +26,13 @@ struct Window
 	SDL_Window * handle;
 	SDL_Renderer * renderer;
 	SDL_Texture * texture;
+	// Pixels of the locked streaming texture, valid until the next render()
 	int32_t * framebuffer;
+	// Framebuffer row length in pixels, may exceed width
+	int stride;
+	// Retained windows draw into their own memory, render() uploads only rows [dirty_top, dirty_bottom)
+	bool retained;
+	int dirty_top, dirty_bottom;
 };
 
 Window * create(
@@ -25,9 +40,12 @@ Window * create(
 	int width = 160,
 	int height = 144,
 	int scale = 1,
-	bool fullscreen = false
+	bool fullscreen = false,
+	bool retained = false
 );
 void free(Window * w);
+// Present the framebuffer, then lock the texture again for the next frame.
+// A locked texture does not keep its pixels, only retained windows may redraw part of the image.
 void render(Window * w);
 void clear(Window * w, const int32_t argb);
 void set_pixel(
@@ -37,6 +55,15 @@ void set_pixel(
 	uint8_t g,
 	uint8_t b
 );
+// Convert rows [y, y + rows) of a width * height source image into the framebuffer, rows < 0 means until the end
+void blit(
+	Window * w,
+	const void * src,
+	Format format,
+	const int32_t * palette = nullptr,
+	int y = 0,
+	int rows = -1
+);
 
 }
 
@@ -0,0 +1,110 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "3rdparty/mlibc_log.h"
+#include "emu/emulator.h"
+#include "emu/frame_pacer.h"
+#include "util/frame_timer.h"
+#include "util/hash.h"
+
+// Runs a ROM for a fixed number of frames as fast as possible, no display or input
+int main(int argc, char * argv[])
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "usage: %s <rom> [frames] [boot|noboot] [trace file|-] [profile.csv|.json|-] [sample prefix]\n", argv[0]);
+		return 1;
+	}
+
+	std::string rom = argv[1];
+	unsigned frames = (argc > 2) ? static_cast<unsigned>(strtoul(argv[2], NULL, 10)) : 600;
+	bool boot_rom = (argc > 3) ? std::string(argv[3]) != "noboot" : true;
+	std::string trace_fp = (argc > 4 && std::string(argv[4]) != "-") ? argv[4] : "";
+	std::string profile_fp = (argc > 5 && std::string(argv[5]) != "-") ? argv[5] : "";
+	std::string sample_fp = (argc > 6) ? argv[6] : "";
+
+	// Init mlibc_log, errors only
+	int return_code = mlibc_log_init(MLIBC_LOG_LEVEL_ERR);
+	if (return_code != MLIBC_LOG_CODE_OK)
+	{
+		throw std::runtime_error("::main(), mlibc_log_init error: " + std::to_string(return_code));
+	}
+
+	// Create the machine
+	hgb::Emulator emu;
+	emu.loadROM(rom);
+
+	if (!boot_rom)
+		emu.skipBootROM();
+
+	// Last instructions before the end of the run, or before a crash
+	std::unique_ptr<hgb::Trace> trace;
+	if (!trace_fp.empty())
+	{
+		trace.reset(new hgb::Trace());
+		trace->dumpOnCrash(trace_fp);
+		emu.getCPU().setTrace(trace.get());
+	}
+
+	// Opcode counts & cycles for the whole run
+	std::unique_ptr<hgb::Profile> profile;
+	if (!profile_fp.empty())
+	{
+		profile.reset(new hgb::Profile());
+		emu.getCPU().setProfile(profile.get());
+	}
+
+	// Guest hot spots, named from the RGBDS symbol file next to the ROM if there is one
+	std::unique_ptr<hgb::Sampler> sampler;
+	if (!sample_fp.empty())
+	{
+		sampler.reset(new hgb::Sampler());
+		sampler->loadSymbols(rom.substr(0, rom.find_last_of('.')) + ".sym");
+		emu.getCPU().setSampler(sampler.get());
+	}
+
+	// Host time per frame, cheap enough to always be on
+	hgb::FrameTimer timer;
+	emu.setFrameTimer(&timer);
+
+	// Run whole frames, a frame worth of cycles counts as one while the LCD is off
+	auto start = std::chrono::steady_clock::now();
+	uint64_t cycles = 0;
+
+	for (unsigned i = 0; i < frames; i++)
+	{
+		cycles += emu.runFrame();
+		timer.endFrame();
+	}
+
+	emu.getPPU().flush();
+
+	if (trace)
+		trace->dump(trace_fp);
+
+	if (profile)
+		profile->write(profile_fp);
+
+	if (sampler)
+	{
+		sampler->writeReport(sample_fp + ".txt");
+		sampler->writeCollapsed(sample_fp + ".folded");
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("rom: %s\n", rom.c_str());
+	printf("frames: %u\n", frames);
+	printf("cycles: %llu\n", static_cast<unsigned long long>(cycles));
+	printf("seconds: %.3f\n", seconds);
+	printf("speed: %.2fx\n", (seconds > 0.0) ? cycles / (seconds * PPU_CYCLES_FRAME * FRAME_PACER_HZ) : 0.0);
+	printf("host: %s\n", hgb::FrameTimer::format(timer.getStats()).c_str());
+	printf("screen: %016llx\n", static_cast<unsigned long long>(hgb::fnv1a(emu.getPPU().getFramebuffer(), PPU_LCD_W * PPU_LCD_H)));
+
+	mlibc_log_free();
+
+	return 0;
+}
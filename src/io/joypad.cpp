@@ -8,15 +8,49 @@ Joypad::Joypad() :
 		0xFF00,
 		0x0000
 	),
-	P1()
+	P1(0x30),
+	m_keys()
 {
 
 }
 
+void Joypad::setKeys(byte keys, bool pressed)
+{
+	m_keys = (pressed) ? (m_keys | keys) : (m_keys & ~keys);
+}
+
+byte Joypad::getKeys()
+{
+	return m_keys;
+}
+
+void Joypad::saveState(JoypadState & state)
+{
+	state.P1 = P1;
+	state.keys = m_keys;
+}
+
+void Joypad::loadState(const JoypadState & state)
+{
+	P1 = state.P1;
+	m_keys = state.keys;
+}
+
 byte Joypad::read(word addr)
 {
 	if (addr == IO_REG_P1)
-		return P1;
+	{
+		// Unused bits read as 1, keys on selected lines pull their bit low
+		byte value = 0xCF | (P1 & 0x30);
+
+		if ((P1 & IO_P1_DIRECTIONS) == 0)
+			value &= ~(m_keys & 0x0F);
+
+		if ((P1 & IO_P1_BUTTONS) == 0)
+			value &= ~(m_keys >> 4);
+
+		return value;
+	}
 
 	return 0x00;
 }
@@ -24,7 +58,7 @@ byte Joypad::read(word addr)
 void Joypad::write(word addr, byte value)
 {
 	if (addr == IO_REG_P1)
-		P1 = value;
+		P1 = value & 0x30;
 }
 
 }
\ No newline at end of file
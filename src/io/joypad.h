@@ -8,15 +8,45 @@ namespace hgb
 
 #define IO_REG_P1	0xFF00	// joypad (R/W)
 
+// P1 line select bits, active low
+#define IO_P1_DIRECTIONS	0x10	// select direction keys
+#define IO_P1_BUTTONS		0x20	// select button keys
+
+// Joypad keys
+#define JOYPAD_RIGHT	0x01
+#define JOYPAD_LEFT		0x02
+#define JOYPAD_UP		0x04
+#define JOYPAD_DOWN		0x08
+#define JOYPAD_A		0x10
+#define JOYPAD_B		0x20
+#define JOYPAD_SELECT	0x40
+#define JOYPAD_START	0x80
+
+// Savestate image
+struct JoypadState
+{
+	byte P1;
+	byte keys;
+};
+
 class Joypad : public MemoryArea
 {
 public:
 	Joypad();
 
+	// Press or release key(s), JOYPAD_* bits
+	void setKeys(byte keys, bool pressed);
+	byte getKeys();
+
+	void saveState(JoypadState & state);
+	void loadState(const JoypadState & state);
+
 	virtual byte read(word addr) override;
 	virtual void write(word addr, byte value) override;
 private:
 	byte P1;
+	// Currently pressed keys, active high
+	byte m_keys;
 };
 
 }
@@ -16,6 +16,22 @@ Timer::Timer() :
 
 }
 
+void Timer::saveState(TimerState & state)
+{
+	state.DIV = DIV;
+	state.TIMA = TIMA;
+	state.TMA = TMA;
+	state.TAC = TAC;
+}
+
+void Timer::loadState(const TimerState & state)
+{
+	DIV = state.DIV;
+	TIMA = state.TIMA;
+	TMA = state.TMA;
+	TAC = state.TAC;
+}
+
 byte Timer::read(word addr)
 {
 	if (addr == TIMER_REG_DIV)
@@ -13,11 +13,23 @@ namespace hgb
 #define TIMER_REG_TMA	0xFF06	// timer modulo register (R/W)
 #define TIMER_REG_TAC	0xFF07	// timer control register (R/W)
 
+// Savestate image
+struct TimerState
+{
+	byte DIV;
+	byte TIMA;
+	byte TMA;
+	byte TAC;
+};
+
 class Timer : public MemoryArea
 {
 public:
 	Timer();
 
+	void saveState(TimerState & state);
+	void loadState(const TimerState & state);
+
 	virtual byte read(word addr) override;
 	virtual void write(word addr, byte value) override;
 private:
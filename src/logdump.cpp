@@ -0,0 +1,25 @@
+#include <cstdio>
+#include <stdexcept>
+#include "util/async_log.h"
+
+// Decodes a binary AsyncLog file into text lines on stdout
+int main(int argc, char * argv[])
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "usage: %s <binary log>\n", argv[0]);
+		return 1;
+	}
+
+	try
+	{
+		hgb::AsyncLog::decode(argv[1], stdout);
+	}
+	catch (const std::exception & e)
+	{
+		fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+
+	return 0;
+}
@@ -1,24 +1,206 @@
+#include <cstdio>
 #include <iostream>
 #include <vector>
+#include <memory>
+#include <thread>
 #include <SDL2/SDL.h>
 #include "3rdparty/mlibc_log.h"
+#include "util/async_log.h"
 #include "emu/window.h"
-#include "mem/memory_area.h"
-#include "mem/rom.h"
-#include "mem/ram.h"
-#include "cpu/irq.h"
-#include "io/joypad.h"
-#include "io/timer.h"
-#include "ppu/ppu.h"
-#include "mem/mmu.h"
-#include "cpu/cpu.h"
-
-mlibc_log_logger * mlibc_log_instance = NULL;
+#include "emu/frame_pacer.h"
+#include "util/frame_timer.h"
+#include "emu/rewind.h"
+#include "emu/emulator.h"
+#include "util/spsc_queue.h"
+#include "util/triple_buffer.h"
+
+// DMG shades 0-3 as ARGB
+static const int32_t LCD_PALETTE[4] = {
+	static_cast<int32_t>(0xFFE0F8D0),
+	static_cast<int32_t>(0xFF88C070),
+	static_cast<int32_t>(0xFF346856),
+	static_cast<int32_t>(0xFF081820)
+};
+
+// Presenter -> emulation thread
+struct Command
+{
+	enum Command_t
+	{
+		KEYS = 0,	// every held joypad key, replaces the previous set
+		SPEED = 1,	// speed multiplier, 0 for unthrottled
+		SAVE = 2,	// quick save to memory
+		LOAD = 3,	// quick load from memory
+		REWIND = 4,	// start / stop rewinding
+		QUIT = 5	// stop emulation
+	} type;
+	byte keys;
+	bool pressed;
+	int speed;
+};
+
+// Emulation thread -> presenter, slots start zeroed
+struct Frame
+{
+	unsigned number;
+	bool rendered;
+	byte lcd[PPU_LCD_W * PPU_LCD_H];
+	// Publish # the memory is current as of & the publish # every page last changed in
+	unsigned published;
+	unsigned page_changed[0x100];
+	byte memory[0x10000];
+};
+
+static hgb::SPSCQueue<Command, 64> commands;
+static hgb::TripleBuffer<Frame> frames;
+
+// Emulation thread, runs whole frames and publishes them, never waits for the presenter
+static void emulate(hgb::Emulator & emu)
+{
+	hgb::PPU & ppu = emu.getPPU();
+	hgb::MMU & mmu = emu.getMMU();
+	// Every page starts out changed so each slot gets one full copy
+	std::vector<unsigned> page_changed(0x100, 1);
+	unsigned published = 0;
+	hgb::FramePacer pacer;
+	hgb::FrameTimer timer;
+	std::unique_ptr<hgb::SaveState> state;
+	hgb::Rewind rewind;
+	bool rewinding = false;
+	bool running = true;
+
+	emu.setFrameTimer(&timer);
+
+	while (running)
+	{
+		// Apply input & commands
+		Command command;
+		while (commands.pop(command))
+		{
+			switch (command.type)
+			{
+				case Command::KEYS:
+				{
+					emu.getJoypad().setKeys(static_cast<byte>(~command.keys), false);
+					emu.getJoypad().setKeys(command.keys, true);
+				} break;
+				case Command::SPEED:
+				{
+					if (command.speed == 0)
+						pacer.setMode(hgb::FramePacer::TURBO);
+					else if (command.speed == 1)
+						pacer.setMode(hgb::FramePacer::NORMAL);
+					else
+						pacer.setMode(hgb::FramePacer::MULTIPLIER, command.speed);
+				} break;
+				case Command::SAVE:
+				{
+					if (!state)
+						state.reset(new hgb::SaveState());
+					emu.saveState(*state);
+				} break;
+				case Command::LOAD:
+				{
+					if (state)
+						emu.loadState(*state);
+				} break;
+				case Command::REWIND: rewinding = command.pressed; break;
+				case Command::QUIT: running = false; break;
+			}
+		}
+
+		// Step back through the history while rewinding, run & record otherwise
+		if (rewinding)
+		{
+			rewind.rewind(emu);
+		}
+		else
+		{
+			emu.runFrame();
+			rewind.capture(emu);
+		}
+
+		uint64_t start = hgb::cycleClock();
+
+		published++;
+
+		for (int page = 0; page < 0x100; page++)
+		{
+			if (mmu.isDirty(static_cast<byte>(page)))
+				page_changed[page] = published;
+		}
+
+		mmu.clearDirty();
+
+		// Publish, the slot catches up on pages that changed since it was last filled, straight from backing memory
+		Frame & out = frames.back();
+		out.number = ppu.getFrame();
+		out.rendered = ppu.isFrameRendered();
+		std::copy(ppu.getFramebuffer(), ppu.getFramebuffer() + PPU_LCD_W * PPU_LCD_H, out.lcd);
+
+		for (int page = 0; page < 0x100; page++)
+		{
+			if (page_changed[page] > out.published)
+				mmu.peek(static_cast<byte>(page), &out.memory[page << 8]);
+		}
+
+		std::copy(page_changed.begin(), page_changed.end(), out.page_changed);
+		out.published = published;
+		frames.publish();
+
+		timer.add(FRAME_TIMER_PUBLISH, hgb::cycleClock() - start);
+		timer.endFrame();
+		pacer.wait();
+
+		// Frame pacing summary every ~10 seconds
+		hgb::FramePacerStats stats = pacer.getStats();
+		if (stats.frames >= 600)
+		{
+			mlibc_inf("::emulate(), pacing: frames: %llu, late: %llu, error mean: %.1fus, stddev: %.1fus, max: %.1fus",
+					  static_cast<unsigned long long>(stats.frames),
+					  static_cast<unsigned long long>(stats.late),
+					  stats.mean_us,
+					  stats.stddev_us,
+					  stats.max_us
+			);
+			pacer.resetStats();
+
+			mlibc_inf("::emulate(), host time: %s", hgb::FrameTimer::format(timer.getStats()).c_str());
+			timer.resetStats();
+		}
+	}
+
+	emu.setFrameTimer(nullptr);
+}
+
+// Map keyboard keys to joypad keys
+static byte keymap(SDL_Keycode key)
+{
+	switch (key)
+	{
+		case SDLK_RIGHT: return JOYPAD_RIGHT;
+		case SDLK_LEFT: return JOYPAD_LEFT;
+		case SDLK_UP: return JOYPAD_UP;
+		case SDLK_DOWN: return JOYPAD_DOWN;
+		case SDLK_x: return JOYPAD_A;
+		case SDLK_z: return JOYPAD_B;
+		case SDLK_BACKSPACE: return JOYPAD_SELECT;
+		case SDLK_RETURN: return JOYPAD_START;
+	}
+
+	return 0x00;
+}
 
 int main(int argc, char * argv[])
 {
 	int return_code = 0;
 
+	if (argc < 2)
+	{
+		fprintf(stderr, "usage: %s <rom>\n", argv[0]);
+		return 1;
+	}
+
 	// Init mlibc_log
 	return_code = mlibc_log_init(MLIBC_LOG_LEVEL_DBG);
 	if (return_code != MLIBC_LOG_CODE_OK)
@@ -27,6 +209,9 @@ int main(int argc, char * argv[])
 	}
 	mlibc_inf("::main(), mlibc_log_init successful.");
 
+	// Emulation thread messages are formatted & printed off its back
+	hgb::AsyncLog::start(hgb::AsyncLog::SINK_TEXT);
+
 	// Init SDL2
 	return_code = SDL_Init(SDL_INIT_VIDEO);
 	if (return_code != 0)
@@ -36,67 +221,167 @@ int main(int argc, char * argv[])
 	mlibc_inf("::main(), SDL2 Initialized successfully.");
 
 	// Create memory debug window
-	auto window_memory = Window::create("MEMORY", 256, 256, 2, false);
+	auto window_memory = Window::create("MEMORY", 256, 256, 2, false, true);
 
-	// Create I/O devices
-	hgb::IRQ irq;
-	hgb::Joypad joy;
-	hgb::Timer timer;
-	hgb::PPU ppu;
+	// Create LCD window
+	auto window_lcd = Window::create("LCD", 160, 144, 3, false);
 
-	// Create MMU
-	hgb::MMU mmu(irq, joy, timer, ppu);
+	// Create the machine
+	hgb::Emulator emu;
 
-	// Create CPU
-	hgb::CPU cpu(mmu);
-
-	cpu.getBreakpoints().push_back(0x0100);
+	emu.getCPU().getBreakpoints().push_back(0x0100);
 
 	// Load ROM file
-	cpu.getMMU().loadROM("Tetris-USA.gb");
+	emu.loadROM(argv[1]);
+
+	// Memory view palettes, ROM in red, VRAM in green, everything else in blue
+	int32_t palette_rom[256], palette_vram[256], palette_other[256];
+	// Publish # of the memory last drawn
+	unsigned memory_drawn = 0;
+	for (int i = 0; i < 256; i++)
+	{
+		palette_rom[i] = i << 16;
+		palette_vram[i] = i << 8;
+		palette_other[i] = i;
+	}
+
+	// From here on the machine belongs to the emulation thread
+	std::thread emulation(emulate, std::ref(emu));
 
-	// Run the CPU, visualize memory
+	// Present frames & handle SDL2 events
+	hgb::FrameTimer timer;
 	bool running = true;
-	int frame = 0;
+	// Latest state is sent whole, a push that finds the queue full is retried on the next pass so no release gets lost
+	byte keys_held = 0x00;
+	bool keys_pending = false;
+	bool rewinding = false;
+	bool rewind_pending = false;
+	bool speed_turbo = false;
+	int speed = 1;
+	bool speed_pending = false;
+	// Quick save & load requests, retried the same way
+	bool save_pending = false;
+	bool load_pending = false;
 	while (running)
 	{
-		// CPU tick
-		cpu.tick();
+		SDL_Event evt;
+		if (SDL_WaitEventTimeout(&evt, 1))
+		{
+			hgb::FrameTimerScope scope(&timer, FRAME_TIMER_EVENTS);
+
+			do
+			{
+				switch (evt.type)
+				{
+					case SDL_QUIT:
+					{
+						running = false;
+					} break;
+					case SDL_KEYDOWN:
+					case SDL_KEYUP:
+					{
+						if (evt.key.repeat != 0)
+							break;
 
-		// PPU tick
-		ppu.tick();
+						bool pressed = evt.type == SDL_KEYDOWN;
+						byte keys = keymap(evt.key.keysym.sym);
 
-		if (frame % 1000 == 0)
+						if (keys != 0x00)
+						{
+							keys_held = (pressed) ? (keys_held | keys) : (keys_held & ~keys);
+							keys_pending = true;
+						}
+
+						// F5 quick saves, F8 quick loads, hold R to rewind
+						if (evt.key.keysym.sym == SDLK_r)
+						{
+							rewinding = pressed;
+							rewind_pending = true;
+						}
+						else if (pressed && evt.key.keysym.sym == SDLK_F5)
+							save_pending = true;
+						else if (pressed && evt.key.keysym.sym == SDLK_F8)
+							load_pending = true;
+
+						// Hold tab for turbo, 1 / 2 / 4 pick the speed multiplier
+						switch (evt.key.keysym.sym)
+						{
+							case SDLK_TAB: speed_turbo = pressed; break;
+							case SDLK_1: if (pressed) speed = 1; break;
+							case SDLK_2: if (pressed) speed = 2; break;
+							case SDLK_4: if (pressed) speed = 4; break;
+							default: continue;
+						}
+
+						speed_pending = true;
+					} break;
+				}
+			} while (SDL_PollEvent(&evt));
+		}
+
+		if (keys_pending)
+			keys_pending = !commands.push({ Command::KEYS, keys_held, false, 0 });
+
+		if (rewind_pending)
+			rewind_pending = !commands.push({ Command::REWIND, 0x00, rewinding, 0 });
+
+		if (speed_pending)
+			speed_pending = !commands.push({ Command::SPEED, 0x00, false, (speed_turbo) ? 0 : speed });
+
+		// A load waits for a pending save so the two stay in order
+		if (save_pending)
+			save_pending = !commands.push({ Command::SAVE, 0x00, false, 0 });
+
+		if (load_pending && !save_pending)
+			load_pending = !commands.push({ Command::LOAD, 0x00, false, 0 });
+
+		if (frames.update())
 		{
-			// Render memory
-			for (word i = 0; i < 0xFFFF; i++)
+			uint64_t start = hgb::cycleClock();
+			const Frame & frame = frames.front();
+
+			if (frame.rendered)
 			{
-				byte val = cpu.getMMU().read(i);
+				Window::blit(window_lcd, frame.lcd, Window::FORMAT_SHADE2, LCD_PALETTE);
+				Window::render(window_lcd);
+			}
 
-				byte r = 0x00, g = 0x00, b = 0x00;
-				r = (i >= 0x0000 && i < 0x8000) ? val : 0x00;
-				g = (i >= 0x8000 && i < 0xA000) ? val : 0x00;
-				b = (i >= 0xA000) ? val : 0x00;
+			// Render memory, one 256-byte page per row, only the pages that changed since the last frame drawn
+			for (int page = 0; page < 0x100; page++)
+			{
+				if (frame.page_changed[page] <= memory_drawn)
+					continue;
 
-				Window::set_pixel(window_memory, i, r, g, b);
+				const int32_t * palette = (page < 0x80) ? palette_rom : (page < 0xA0) ? palette_vram : palette_other;
+				Window::blit(window_memory, frame.memory, Window::FORMAT_INDEXED8, palette, page, 1);
 			}
 
+			memory_drawn = frame.published;
 			Window::render(window_memory);
 
-			// Handle SDL2 events
-			SDL_Event evt;
-			while (SDL_PollEvent(&evt))
+			timer.add(FRAME_TIMER_PRESENT, hgb::cycleClock() - start);
+			timer.endFrame();
+
+			// Presenter time summary every ~600 presented frames
+			hgb::FrameTimerStats stats = timer.getStats();
+			if (stats.frames >= 600)
 			{
-				switch (evt.type)
-				{
-					case SDL_QUIT: running = false; break;
-				}
+				mlibc_inf("::main(), host time: %s", hgb::FrameTimer::format(stats).c_str());
+				timer.resetStats();
 			}
 		}
+	}
 
-		frame++;
+	// Stop emulation, retry until the command fits in the queue
+	while (!commands.push({ Command::QUIT, 0x00, false, 0 }))
+	{
+		std::this_thread::yield();
 	}
+	emulation.join();
+
+	hgb::AsyncLog::stop();
 
+	Window::free(window_lcd);
 	Window::free(window_memory);
 
 	return 0;
@@ -9,8 +9,8 @@ namespace hgb
 // Boot ROM sizes in bytes
 #define BOOTROM_DMG01_SIZE 256
 
-// DMG-01 Game Boy boot ROM program
-byte BOOTROM_DMG01[BOOTROM_DMG01_SIZE] = {
+// DMG-01 Game Boy boot ROM program, read-only and shared by every machine
+static const byte BOOTROM_DMG01[BOOTROM_DMG01_SIZE] = {
 	0x31, 0xFE, 0xFF, 0xAF, 0x21, 0xFF, 0x9F, 0x32, 0xCB, 0x7C, 0x20, 0xFB, 0x21, 0x26, 0xFF, 0x0E,
 	0x11, 0x3E, 0x80, 0x32, 0xE2, 0x0C, 0x3E, 0xF3, 0xE2, 0x32, 0x3E, 0x77, 0x77, 0x3E, 0xFC, 0xE0,
 	0x47, 0x11, 0x04, 0x01, 0x21, 0x10, 0x80, 0x1A, 0xCD, 0x95, 0x00, 0xCD, 0x96, 0x00, 0x13, 0x7B,
@@ -1,5 +1,6 @@
 #include "memory_area.h"
 #include <algorithm>
+#include <cstring>
 #include "3rdparty/mlibc_log.h"
 
 namespace hgb
@@ -7,21 +8,26 @@ namespace hgb
 
 MemoryArea::MemoryArea(
 	word address,
-	size_t size
+	size_t size,
+	bool allocate
 ) :
 	m_address(address),
 	m_size(size),
-	m_memory(new byte[m_size])
+	m_storage(),
+	m_memory(nullptr)
 {
-	std::fill_n(m_memory, m_size, 0x00);
+	if (allocate)
+	{
+		m_storage.reset(new byte[m_size], std::default_delete<byte[]>());
+		m_memory = m_storage.get();
+		std::fill_n(m_memory, m_size, 0x00);
+	}
 
 	mlibc_dbg("MemoryArea::MemoryArea(address:0x%04zx, size:%zu)", m_address, m_size);
 }
 
 MemoryArea::~MemoryArea()
 {
-	delete m_memory;
-
 	mlibc_dbg("MemoryArea::~MemoryArea(), address: 0x%04zx, size: %zu", m_address, m_size);
 }
 
@@ -40,6 +46,22 @@ byte * MemoryArea::getMemory()
 	return m_memory;
 }
 
+void MemoryArea::peek(size_t offset, byte * dst, size_t size)
+{
+	std::memcpy(dst, m_memory + offset, size);
+}
+
+void MemoryArea::poke(size_t offset, const byte * src, size_t size)
+{
+	std::memcpy(m_memory + offset, src, size);
+}
+
+void MemoryArea::share(MemoryArea & other)
+{
+	m_storage = other.m_storage;
+	m_memory = other.m_memory;
+}
+
 word MemoryArea::map(word addr)
 {
 	return addr - m_address;
@@ -1,6 +1,8 @@
 #ifndef MEMORY_AREA_H
 #define MEMORY_AREA_H
 
+#include <cstddef>
+#include <memory>
 #include "data_types.h"
 
 namespace hgb
@@ -11,7 +13,8 @@ class MemoryArea
 public:
 	MemoryArea(
 		word address = 0x0000,
-		size_t size = 0x8000
+		size_t size = 0x8000,
+		bool allocate = true
 	);
 	virtual ~MemoryArea();
 
@@ -21,6 +24,12 @@ public:
 	virtual byte read(word addr) = 0;
 	// Set a byte in the MemoryArea at specified 16-bit address
 	virtual void write(word addr, byte value) = 0;
+	// Copy bytes out of / into the backing memory, no side effects
+	virtual void peek(size_t offset, byte * dst, size_t size);
+	virtual void poke(size_t offset, const byte * src, size_t size);
+	// Use the backing memory of another area of the same size, both see the same bytes from now on.
+	// Only meant for contents that never change, writable areas override this with copy-on-write
+	virtual void share(MemoryArea & other);
 
 	virtual word getAddress();
 	virtual size_t getSize();
@@ -28,6 +37,8 @@ public:
 protected:
 	word m_address;
 	size_t m_size;
+	// Backing memory, m_memory points into it, empty for areas that manage memory on their own
+	std::shared_ptr<byte> m_storage;
 	byte * m_memory;
 };
 
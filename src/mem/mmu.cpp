@@ -1,11 +1,14 @@
 #include "mmu.h"
 #include <stdexcept>
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
 #include "3rdparty/mlibc_log.h"
 #include "mem/bootrom.h"
 #include "mem/memory_area.h"
 #include "mem/rom.h"
 #include "mem/ram.h"
+#include "mem/oam.h"
 #include "cpu/irq.h"
 #include "io/joypad.h"
 #include "io/timer.h"
@@ -20,7 +23,7 @@ MMU::MMU(
 	MemoryArea & timer,
 	MemoryArea & ppu
 ) :
-	m_cart(nullptr),
+	m_cart(),
 	m_bootrom(nullptr),
 	m_rom(),
 	m_ram(),
@@ -29,7 +32,8 @@ MMU::MMU(
 	m_timer(timer),
 	m_ppu(ppu),
 	m_ff50(),
-	m_hram(nullptr)
+	m_hram(nullptr),
+	m_dirty()
 {
 	// Init boot ROM
 	m_bootrom = new ROM(0x0000, 0x0100);
@@ -51,6 +55,9 @@ MMU::MMU(
 	// Init HRAM
 	m_hram = new RAM(MMU_HRAM, MMU_HRAM_SZ);
 
+	// Nothing has been seen yet
+	std::fill_n(m_dirty, 4, ~static_cast<uint64_t>(0));
+
 	mlibc_dbg("MMU::MMU(...)");
 }
 
@@ -74,23 +81,32 @@ MMU::~MMU()
 	// Free boot ROM from memory
 	delete m_bootrom;
 
-	// Free cartridge data
-	delete m_cart;
-
 	mlibc_dbg("MMU::~MMU(...)");
 }
 
 void MMU::loadROM(const std::string & fp)
 {
-	// Init new cartridge instance
-	m_cart = new Cartridge;
-
 	// Load file as binary + get file size
 	FILE * file_ptr = fopen(fp.c_str(), "rb");
 
 	if (file_ptr == NULL)
 		throw std::runtime_error("MMU::loadROM(...), error! fopen returned a NULL pointer!");
 
+	// Init new cartridge instance, clones may still hold the previous one
+	m_cart.reset(new Cartridge(), [](Cartridge * cart)
+	{
+		delete[] cart->data;
+		delete cart;
+	});
+
+	// Fresh ROM banks, clones may still share the current ones
+	for (auto & rom : m_rom)
+	{
+		MemoryArea * fresh = new ROM(rom->getAddress(), rom->getSize());
+		delete rom;
+		rom = fresh;
+	}
+
 	fseek(file_ptr, 0, SEEK_END);
 	m_cart->data_len = ftell(file_ptr);
 	rewind(file_ptr);
@@ -161,6 +177,8 @@ void MMU::loadROM(const std::string & fp)
 		rom->getMemory()[addr] = m_cart->data[i];
 	}
 
+	std::fill_n(m_dirty, 4, ~static_cast<uint64_t>(0));
+
 	mlibc_dbg("MMU::loadROM(%s). data_len: %d", fp.c_str(), m_cart->data_len);
 }
 
@@ -196,6 +214,11 @@ MemoryArea * MMU::map(word addr)
 	{
 		return m_ram[0];
 	}
+	// OAM
+	else if (addr >= OAM_S && addr <= OAM_E)
+	{
+		return dynamic_cast<PPU&>(m_ppu).getOAM();
+	}
 	// IRQ ctrl
 	else if (addr == IRQ_REG_IF || addr == IRQ_REG_IE)
 	{
@@ -245,6 +268,8 @@ byte MMU::read(word addr)
 
 void MMU::write(word addr, byte value)
 {
+	markDirty(addr);
+
 	// Get memory area mapped to this address
 	MemoryArea * memory_area = map(addr);
 
@@ -253,17 +278,142 @@ void MMU::write(word addr, byte value)
 	{
 		// enable / disable bootrom register (allow writing to only once!)
 		if (addr == MMU_REG_BOOT && m_ff50 == 0x00)
+		{
 			m_ff50 = value;
 
+			// Boot ROM unmapped, page 0 shows the cartridge now
+			markDirty(0x0000);
+		}
+
 		return;
 	}
 
 	memory_area->write(addr, value);
+
+	// OAM DMA start
+	if (addr == PPU_REG_DMA)
+		dma(value);
+}
+
+void MMU::dma(byte page)
+{
+	// Sources above 0xDFFF read the echoed work RAM
+	if (page >= 0xE0)
+		page -= 0x20;
+
+	word src = word_(page, 0x00);
+	OAM * oam = dynamic_cast<PPU&>(m_ppu).getOAM();
+	MemoryArea * memory_area = map(src);
+
+	markDirty(OAM_S);
+
+	// Whole source page is backed by plain memory, copy it in one go, otherwise go through the regular read path
+	byte buffer[OAM_SZ];
+	if (memory_area != nullptr && static_cast<size_t>(memory_area->map(src) + OAM_SZ) <= memory_area->getSize())
+	{
+		memory_area->peek(memory_area->map(src), buffer, OAM_SZ);
+	}
+	else
+	{
+		for (word i = 0; i < OAM_SZ; i++)
+		{
+			buffer[i] = read(src + i);
+		}
+	}
+
+	oam->load(buffer);
+}
+
+void MMU::peek(byte page, byte * dst)
+{
+	int i = 0;
+
+	while (i < 0x100)
+	{
+		word addr = static_cast<word>(word_(page, 0x00) + i);
+		MemoryArea * memory_area = map(addr);
+
+		// Registers & unmapped addresses have no backing memory
+		if (memory_area == nullptr || memory_area->getSize() == 0)
+		{
+			dst[i++] = 0x00;
+			continue;
+		}
+
+		// Copy as much of the page as this memory area covers
+		size_t offset = memory_area->map(addr);
+		size_t n = std::min(static_cast<size_t>(0x100 - i), memory_area->getSize() - offset);
+		memory_area->peek(offset, dst + i, n);
+		i += static_cast<int>(n);
+	}
+}
+
+byte MMU::peek(word addr)
+{
+	MemoryArea * memory_area = map(addr);
+
+	// Registers & unmapped addresses have no backing memory
+	if (memory_area == nullptr || memory_area->getSize() == 0)
+		return 0x00;
+
+	byte value = 0x00;
+	memory_area->peek(memory_area->map(addr), &value, 1);
+
+	return value;
+}
+
+bool MMU::isDirty(byte page)
+{
+	return (m_dirty[page >> 6] & (static_cast<uint64_t>(1) << (page & 0x3F))) != 0;
+}
+
+void MMU::clearDirty()
+{
+	std::fill_n(m_dirty, 4, 0);
+}
+
+void MMU::saveState(MMUState & state)
+{
+	m_ram[0]->peek(0, state.wram, MMU_RAM_BANK_SZ);
+	m_ram[1]->peek(0, state.cart_ram, MMU_RAM_BANK_SZ);
+	m_hram->peek(0, state.hram, MMU_HRAM_SZ);
+	state.ff50 = m_ff50;
+}
+
+void MMU::loadState(const MMUState & state)
+{
+	m_ram[0]->poke(0, state.wram, MMU_RAM_BANK_SZ);
+	m_ram[1]->poke(0, state.cart_ram, MMU_RAM_BANK_SZ);
+	m_hram->poke(0, state.hram, MMU_HRAM_SZ);
+	m_ff50 = state.ff50;
+
+	std::fill_n(m_dirty, 4, ~static_cast<uint64_t>(0));
+}
+
+void MMU::share(MMU & other)
+{
+	m_cart = other.m_cart;
+	m_bootrom->share(*other.m_bootrom);
+
+	for (size_t i = 0; i < m_rom.size(); i++)
+	{
+		m_rom[i]->share(*other.m_rom[i]);
+	}
+
+	for (size_t i = 0; i < m_ram.size(); i++)
+	{
+		m_ram[i]->share(*other.m_ram[i]);
+	}
+
+	m_hram->share(*other.m_hram);
+	m_ff50 = other.m_ff50;
+
+	std::fill_n(m_dirty, 4, ~static_cast<uint64_t>(0));
 }
 
 Cartridge * MMU::getCart()
 {
-	return m_cart;
+	return m_cart.get();
 }
 
 MemoryArea * MMU::getBootROM()
@@ -276,6 +426,12 @@ MemoryArea * MMU::getROM(size_t index)
 	return m_rom[index];
 }
 
+size_t MMU::getROMBank()
+{
+	// No MBC, bank #1 is always mapped
+	return 1;
+}
+
 MemoryArea * MMU::getRAM(size_t index)
 {
 	return m_ram[index];
@@ -1,6 +1,7 @@
 #ifndef MMU_H
 #define MMU_H
 
+#include <memory>
 #include <vector>
 #include "data_types.h"
 #include "mem/cartridge.h"
@@ -38,6 +39,15 @@ namespace hgb
 
 class MemoryArea;
 
+// Savestate image, ROM contents are not included
+struct MMUState
+{
+	byte wram[MMU_RAM_BANK_SZ];
+	byte cart_ram[MMU_RAM_BANK_SZ];
+	byte hram[MMU_HRAM_SZ];
+	byte ff50;
+};
+
 class MMU
 {
 public:
@@ -57,10 +67,27 @@ public:
 	byte read(word addr);
 	// Set a byte at specified 16-bit address
 	void write(word addr, byte value);
+	// OAM DMA, copy 160 bytes from page XX00 into OAM
+	void dma(byte page);
+	// Copy a 256-byte page straight from backing memory, no side effects, registers read as 0x00
+	void peek(byte page, byte * dst);
+	// Single byte from backing memory, no side effects, registers read as 0x00
+	byte peek(word addr);
+	// Was the page written since the last clearDirty()
+	bool isDirty(byte page);
+	void clearDirty();
+
+	void saveState(MMUState & state);
+	// Every page is dirty after a load
+	void loadState(const MMUState & state);
+	// Start from the memory of another MMU, ROM is shared for good & RAM pages until written
+	void share(MMU & other);
 
 	Cartridge * getCart();
 	MemoryArea * getBootROM();
 	MemoryArea * getROM(size_t index);
+	// # of the ROM bank mapped at 0x4000-0x7FFF
+	size_t getROMBank();
 	MemoryArea * getRAM(size_t index);
 	MemoryArea & getIRQ();
 	MemoryArea & getJoypad();
@@ -69,7 +96,7 @@ public:
 	byte & getFF50();
 	MemoryArea * getHRAM();
 private:
-	Cartridge * m_cart;
+	std::shared_ptr<Cartridge> m_cart;
 	MemoryArea * m_bootrom;
 	std::vector<MemoryArea *> m_rom;
 	std::vector<MemoryArea *> m_ram;
@@ -79,6 +106,13 @@ private:
 	MemoryArea & m_ppu;
 	byte m_ff50;
 	MemoryArea * m_hram;
+	// One bit per 256-byte page
+	uint64_t m_dirty[4];
+
+	inline void markDirty(word addr)
+	{
+		m_dirty[addr >> 14] |= static_cast<uint64_t>(1) << ((addr >> 8) & 0x3F);
+	}
 };
 
 }
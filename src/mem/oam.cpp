@@ -0,0 +1,162 @@
+#include "oam.h"
+#include <algorithm>
+#include <cstring>
+#include "3rdparty/mlibc_log.h"
+#include "ppu/ppu.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace hgb
+{
+
+// Index of the lowest set bit, v must be non-zero
+static inline int lowest_bit(uint64_t v)
+{
+#if defined(_MSC_VER)
+	unsigned long i;
+	if (_BitScanForward(&i, static_cast<unsigned long>(v)))
+		return static_cast<int>(i);
+	_BitScanForward(&i, static_cast<unsigned long>(v >> 32));
+	return static_cast<int>(i) + 32;
+#else
+	return __builtin_ctzll(v);
+#endif
+}
+
+OAM::OAM(
+	PPU & ppu
+) :
+	MemoryArea(
+		OAM_S,
+		OAM_SZ
+	),
+	m_ppu(ppu),
+	m_height(8),
+	m_locked(false),
+	m_lines()
+{
+	// All sprites start at y = 0, which is off-screen, so the index starts out empty
+	mlibc_dbg("OAM::OAM()");
+}
+
+void OAM::setSpriteHeight(int height)
+{
+	if (height == m_height)
+		return;
+
+	m_height = height;
+
+	// Rebuild the whole index for the new height
+	std::fill_n(m_lines, OAM_LINES, 0);
+	for (int i = 0; i < OAM_SPRITES; i++)
+	{
+		index(i, m_memory[i * OAM_SPRITE_SZ + OAM_Y]);
+	}
+}
+
+int OAM::getLine(int ly, byte * sprites)
+{
+	uint64_t mask = m_lines[ly];
+	int count = 0;
+
+	// Lowest bits first, which is OAM order
+	while (mask != 0 && count < OAM_LINE_MAX)
+	{
+		sprites[count++] = static_cast<byte>(lowest_bit(mask));
+		mask &= mask - 1;
+	}
+
+	return count;
+}
+
+void OAM::load(const byte * src)
+{
+	// Drop moved sprites from their old lines before the copy
+	bool moved[OAM_SPRITES];
+	for (int i = 0; i < OAM_SPRITES; i++)
+	{
+		byte y = m_memory[i * OAM_SPRITE_SZ + OAM_Y];
+		moved[i] = y != src[i * OAM_SPRITE_SZ + OAM_Y];
+
+		if (moved[i])
+			unindex(i, y);
+	}
+
+	std::memcpy(m_memory, src, OAM_SZ);
+
+	for (int i = 0; i < OAM_SPRITES; i++)
+	{
+		if (moved[i])
+			index(i, m_memory[i * OAM_SPRITE_SZ + OAM_Y]);
+	}
+}
+
+void OAM::setLocked(bool locked)
+{
+	m_locked = locked;
+}
+
+bool OAM::isLocked()
+{
+	return m_locked;
+}
+
+byte OAM::read(word addr)
+{
+	if (m_locked)
+		return 0xFF;
+
+	return m_memory[map(addr)];
+}
+
+void OAM::write(word addr, byte value)
+{
+	if (m_locked)
+		return;
+
+	// Queued scanlines must see the old contents
+	m_ppu.sync();
+
+	word offset = map(addr);
+	byte old = m_memory[offset];
+
+	m_memory[offset] = value;
+
+	// Moving a sprite vertically moves it between line buckets
+	if (offset % OAM_SPRITE_SZ == OAM_Y && old != value)
+	{
+		int sprite = offset / OAM_SPRITE_SZ;
+		unindex(sprite, old);
+		index(sprite, value);
+	}
+}
+
+void OAM::index(int sprite, byte y)
+{
+	int top = y - 16;
+	int start = std::max(top, 0);
+	int end = std::min(top + m_height, OAM_LINES);
+	uint64_t bit = static_cast<uint64_t>(1) << sprite;
+
+	for (int ly = start; ly < end; ly++)
+	{
+		m_lines[ly] |= bit;
+	}
+}
+
+void OAM::unindex(int sprite, byte y)
+{
+	int top = y - 16;
+	int start = std::max(top, 0);
+	int end = std::min(top + m_height, OAM_LINES);
+	uint64_t bit = ~(static_cast<uint64_t>(1) << sprite);
+
+	for (int ly = start; ly < end; ly++)
+	{
+		m_lines[ly] &= bit;
+	}
+}
+
+}
\ No newline at end of file
@@ -6,13 +6,56 @@
 namespace hgb
 {
 
+#define OAM_S			0xFE00	// oam start
+#define OAM_E			0xFE9F	// oam end
+#define OAM_SZ			0x00A0	// oam size
+#define OAM_SPRITES		40		// # of sprites in oam
+#define OAM_SPRITE_SZ	4		// bytes per sprite (y, x, tile, flags)
+#define OAM_LINES		144		// # of visible scanlines indexed
+#define OAM_LINE_MAX	10		// max # of sprites per scanline
+
+// Sprite attribute byte offsets
+#define OAM_Y			0		// y position + 16
+#define OAM_X			1		// x position + 8
+#define OAM_TILE		2		// tile number
+#define OAM_FLAGS		3		// attribute flags
+
+// Sprite attribute flags
+#define OAM_FLAG_PRIORITY	0x80	// obj behind bg colors 1-3
+#define OAM_FLAG_YFLIP		0x40	// vertical flip
+#define OAM_FLAG_XFLIP		0x20	// horizontal flip
+#define OAM_FLAG_PALETTE	0x10	// palette select (0: OBP0, 1: OBP1)
+
+class PPU;
+
 class OAM : public MemoryArea
 {
 public:
-	OAM();
+	OAM(
+		PPU & ppu
+	);
+
+	// Set sprite height in pixels (8 or 16), rebuilds the line index on change
+	void setSpriteHeight(int height);
+	// Get the sprites (max OAM_LINE_MAX) visible on scanline ly in OAM order, returns the count
+	int getLine(int ly, byte * sprites);
+	// Replace the whole OAM with OAM_SZ bytes from src (DMA), re-indexes moved sprites only
+	void load(const byte * src);
+	// Block CPU access while a DMA transfer owns the bus
+	void setLocked(bool locked);
+	bool isLocked();
 
 	virtual byte read(word addr) override;
 	virtual void write(word addr, byte value) override;
+private:
+	void index(int sprite, byte y);
+	void unindex(int sprite, byte y);
+
+	PPU & m_ppu;
+	int m_height;
+	bool m_locked;
+	// One bit per sprite for every scanline the sprite covers
+	uint64_t m_lines[OAM_LINES];
 };
 
 }
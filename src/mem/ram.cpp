@@ -1,4 +1,6 @@
 #include "ram.h"
+#include <algorithm>
+#include <cstring>
 
 namespace hgb
 {
@@ -9,20 +11,96 @@ RAM::RAM(
 ) :
 	MemoryArea(
 		address,
-		size
-	)
+		size,
+		false
+	),
+	m_pages((size + RAM_PAGE_SZ - 1) / RAM_PAGE_SZ)
 {
+	for (auto & page : m_pages)
+	{
+		page = new Page();
+		page->refs.store(1, std::memory_order_relaxed);
+	}
+}
 
+RAM::~RAM()
+{
+	for (auto page : m_pages)
+	{
+		release(page);
+	}
 }
 
 byte RAM::read(word addr)
 {
-	return m_memory[map(addr)];
+	word offset = map(addr);
+	return m_pages[offset / RAM_PAGE_SZ]->data[offset % RAM_PAGE_SZ];
 }
 
 void RAM::write(word addr, byte value)
 {
-	m_memory[map(addr)] = value;
+	word offset = map(addr);
+	own(offset / RAM_PAGE_SZ)->data[offset % RAM_PAGE_SZ] = value;
+}
+
+void RAM::peek(size_t offset, byte * dst, size_t size)
+{
+	while (size > 0)
+	{
+		size_t n = std::min(size, RAM_PAGE_SZ - offset % RAM_PAGE_SZ);
+		std::memcpy(dst, m_pages[offset / RAM_PAGE_SZ]->data + offset % RAM_PAGE_SZ, n);
+		offset += n;
+		dst += n;
+		size -= n;
+	}
+}
+
+void RAM::poke(size_t offset, const byte * src, size_t size)
+{
+	while (size > 0)
+	{
+		size_t n = std::min(size, RAM_PAGE_SZ - offset % RAM_PAGE_SZ);
+		std::memcpy(own(offset / RAM_PAGE_SZ)->data + offset % RAM_PAGE_SZ, src, n);
+		offset += n;
+		src += n;
+		size -= n;
+	}
+}
+
+void RAM::share(MemoryArea & other)
+{
+	RAM & ram = static_cast<RAM &>(other);
+
+	for (size_t i = 0; i < m_pages.size(); i++)
+	{
+		ram.m_pages[i]->refs.fetch_add(1, std::memory_order_relaxed);
+		release(m_pages[i]);
+		m_pages[i] = ram.m_pages[i];
+	}
 }
 
-}
\ No newline at end of file
+void RAM::release(Page * page)
+{
+	if (page->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		delete page;
+}
+
+RAM::Page * RAM::own(size_t page)
+{
+	Page * p = m_pages[page];
+
+	// Acquire pairs with the other holder letting go, its last reads of the page are done by then
+	if (p->refs.load(std::memory_order_acquire) == 1)
+		return p;
+
+	Page * copy = new Page();
+	copy->refs.store(1, std::memory_order_relaxed);
+	std::memcpy(copy->data, p->data, RAM_PAGE_SZ);
+
+	release(p);
+	m_pages[page] = copy;
+
+	return copy;
+}
+
+}
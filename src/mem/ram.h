@@ -1,11 +1,16 @@
 #ifndef RAM_H
 #define RAM_H
 
+#include <atomic>
+#include <vector>
 #include "mem/memory_area.h"
 
 namespace hgb
 {
 
+#define RAM_PAGE_SZ	0x100	// copy-on-write granularity
+
+// Paged RAM, pages are shared between clones and copied on their first write
 class RAM : public MemoryArea
 {
 public:
@@ -13,11 +18,29 @@ public:
 		word address = 0xC000,
 		size_t size = 0x2000
 	);
+	~RAM();
 
 	virtual byte read(word addr) override;
 	virtual void write(word addr, byte value) override;
+	virtual void peek(size_t offset, byte * dst, size_t size) override;
+	virtual void poke(size_t offset, const byte * src, size_t size) override;
+	// Share every page of another RAM of the same size, either side copies a page on its first write to it
+	virtual void share(MemoryArea & other) override;
+private:
+	// Reference counted by every RAM holding it
+	struct Page
+	{
+		std::atomic<unsigned> refs;
+		byte data[RAM_PAGE_SZ];
+	};
+
+	static void release(Page * page);
+	// Page for writing, copied first if anyone else holds it
+	Page * own(size_t page);
+
+	std::vector<Page *> m_pages;
 };
 
 }
 
-#endif // RAM_H
\ No newline at end of file
+#endif // RAM_H
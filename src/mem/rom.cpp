@@ -25,7 +25,8 @@ byte ROM::read(word addr)
 
 void ROM::write(word addr, byte value)
 {
-	mlibc_wrn("ROM::write(0x%04zx), error! Tried to modify read-only memory!", addr);
+	// MBC bank switches write here, keep them from flooding the log
+	mlibc_wrn_limited("ROM::write(0x%04zx), error! Tried to modify read-only memory!", addr);
 }
 
 }
\ No newline at end of file
@@ -0,0 +1,39 @@
+#include "vram.h"
+#include "ppu/ppu.h"
+
+namespace hgb
+{
+
+VRAM::VRAM(
+	PPU & ppu,
+	word address,
+	size_t size
+) :
+	MemoryArea(
+		address,
+		size
+	),
+	m_ppu(ppu),
+	m_tile_version()
+{
+
+}
+
+byte VRAM::read(word addr)
+{
+	return m_memory[map(addr)];
+}
+
+void VRAM::write(word addr, byte value)
+{
+	// Queued scanlines must see the old contents
+	m_ppu.sync();
+
+	word offset = map(addr);
+	m_memory[offset] = value;
+
+	if (offset < VRAM_TILES_SZ)
+		m_tile_version[offset >> 4]++;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#ifndef VRAM_H
+#define VRAM_H
+
+#include "mem/memory_area.h"
+
+namespace hgb
+{
+
+#define VRAM_TILES		384		// # of 16-byte tiles in tile data (0x8000-0x97FF)
+#define VRAM_TILES_SZ	0x1800	// tile data size
+
+class PPU;
+
+class VRAM : public MemoryArea
+{
+public:
+	VRAM(
+		PPU & ppu,
+		word address = 0x8000,
+		size_t size = 0x2000
+	);
+
+	// Bumped on every write to the tile, lets caches detect stale tiles
+	inline unsigned getTileVersion(int tile)
+	{
+		return m_tile_version[tile];
+	}
+
+	virtual byte read(word addr) override;
+	virtual void write(word addr, byte value) override;
+private:
+	PPU & m_ppu;
+	unsigned m_tile_version[VRAM_TILES];
+};
+
+}
+
+#endif // VRAM_H
\ No newline at end of file
@@ -1,15 +1,48 @@
 #include "ppu.h"
+#include <algorithm>
+#include <chrono>
+#include <utility>
 #include "3rdparty/mlibc_log.h"
-#include "mem/ram.h"
+#include "util/frame_timer.h"
+#include "mem/vram.h"
+#include "cpu/irq.h"
 
 namespace hgb
 {
 
-PPU::PPU() :
+PPU::PPU(
+	IRQ & irq
+) :
 	MemoryArea(
 		0xFF04,
 		0x0000
 	),
+	m_irq(irq),
+	m_vram(nullptr),
+	m_oam(nullptr),
+	m_map_cache(),
+	m_map_tile(),
+	m_map_version(),
+	m_framebuffer(),
+	m_line_bg(),
+	m_line(),
+	m_line_dirty(false),
+	m_pipelined(false),
+	m_pipeline(),
+	m_lines_queued(0),
+	m_lines_done(0),
+	m_worker_running(false),
+	m_worker(),
+	m_clock(0),
+	m_dma_cycles(0),
+	m_frame(0),
+	m_frame_rendered(false),
+	m_render_frame(true),
+	m_render_mode(RENDER_ALL),
+	m_render_interval(1),
+	m_render_requested(false),
+	m_window_line(0),
+	m_frame_timer(nullptr),
 	LCDC(),
 	STAT(),
 	SCY(),
@@ -24,22 +57,261 @@ PPU::PPU() :
 	WX()
 {
 	// Init VRAM
-	m_vram = new RAM(PPU_VRAM, PPU_VRAM_SZ);
+	m_vram = new VRAM(*this, PPU_VRAM, PPU_VRAM_SZ);
+
+	// Init OAM
+	m_oam = new OAM(*this);
+
+	// Init bg map caches, every tile starts out stale so the pixels are drawn before they are read
+	for (int i = 0; i < PPU_MAPS; i++)
+	{
+		m_map_cache[i] = new byte[PPU_MAP_SZ * PPU_MAP_SZ];
+		std::fill_n(m_map_tile[i], PPU_MAP_TILES * PPU_MAP_TILES, -1);
+	}
+
+	// Init front & back framebuffers
+	for (auto & fb : m_framebuffer)
+	{
+		fb = new byte[PPU_LCD_W * PPU_LCD_H];
+		std::fill_n(fb, PPU_LCD_W * PPU_LCD_H, 0x00);
+	}
 
 	mlibc_dbg("PPU::PPU()");
 }
 
 PPU::~PPU()
 {
+	// Stop the render worker
+	setPipelined(false);
+
+	// Free framebuffers
+	for (auto fb : m_framebuffer)
+	{
+		delete[] fb;
+	}
+
+	// Free bg map caches
+	for (auto cache : m_map_cache)
+	{
+		delete[] cache;
+	}
+
+	// Free OAM
+	delete m_oam;
+
 	// Free VRAM
 	delete m_vram;
 
 	mlibc_dbg("PPU::~PPU()");
 }
 
-void PPU::tick()
+void PPU::tick(int cycles)
+{
+	// Pending OAM DMA completion, the copy itself was done at once by the MMU
+	if (m_dma_cycles > 0)
+	{
+		m_dma_cycles -= cycles;
+
+		if (m_dma_cycles <= 0)
+			m_oam->setLocked(false);
+	}
+
+	// LCD is off, nothing to do
+	if ((LCDC & PPU_LCDC_ON) == 0)
+		return;
+
+	m_clock += cycles;
+
+	// Step through every mode transition that fits in the elapsed cycles
+	while (true)
+	{
+		switch (STAT & PPU_STAT_MODE)
+		{
+			case PPU_MODE_OAM:
+			{
+				if (m_clock < PPU_CYCLES_OAM)
+					return;
+
+				m_clock -= PPU_CYCLES_OAM;
+				beginLine();
+				setMode(PPU_MODE_TRANSFER);
+			} break;
+			case PPU_MODE_TRANSFER:
+			{
+				if (m_clock < PPU_CYCLES_TRANSFER)
+					return;
+
+				m_clock -= PPU_CYCLES_TRANSFER;
+				endLine();
+				setMode(PPU_MODE_HBLANK);
+			} break;
+			case PPU_MODE_HBLANK:
+			{
+				if (m_clock < PPU_CYCLES_HBLANK)
+					return;
+
+				m_clock -= PPU_CYCLES_HBLANK;
+				setLY(LY + 1);
+
+				if (LY == PPU_LCD_H)
+				{
+					setMode(PPU_MODE_VBLANK);
+					m_irq.request(IRQ_VBLANK);
+					endFrame();
+				}
+				else
+				{
+					setMode(PPU_MODE_OAM);
+				}
+			} break;
+			case PPU_MODE_VBLANK:
+			{
+				if (m_clock < PPU_CYCLES_LINE)
+					return;
+
+				m_clock -= PPU_CYCLES_LINE;
+
+				if (LY + 1 == PPU_LINES)
+				{
+					setLY(0);
+					beginFrame();
+					setMode(PPU_MODE_OAM);
+				}
+				else
+				{
+					setLY(LY + 1);
+				}
+			} break;
+		}
+	}
+}
+
+void PPU::setRenderMode(RenderMode_t mode, int interval)
 {
-	LY++;
+	m_render_mode = mode;
+	m_render_interval = std::max(interval, 1);
+
+	mlibc_dbg("PPU::setRenderMode(mode:%d, interval:%d)", m_render_mode, m_render_interval);
+}
+
+void PPU::requestFrame()
+{
+	m_render_requested = true;
+}
+
+void PPU::setPipelined(bool pipelined)
+{
+	if (pipelined == m_pipelined)
+		return;
+
+	if (pipelined)
+	{
+		m_worker_running = true;
+		m_worker = std::thread(&PPU::work, this);
+	}
+	else
+	{
+		flush();
+		m_worker_running = false;
+		m_worker.join();
+	}
+
+	m_pipelined = pipelined;
+
+	mlibc_dbg("PPU::setPipelined(%d)", m_pipelined);
+}
+
+void PPU::flush()
+{
+	while (m_lines_done.load(std::memory_order_acquire) != m_lines_queued)
+	{
+		std::this_thread::yield();
+	}
+}
+
+void PPU::setFrameTimer(FrameTimer * frame_timer)
+{
+	m_frame_timer = frame_timer;
+}
+
+void PPU::saveState(PPUState & state)
+{
+	sync();
+
+	std::copy(m_vram->getMemory(), m_vram->getMemory() + PPU_VRAM_SZ, state.vram);
+	std::copy(m_oam->getMemory(), m_oam->getMemory() + OAM_SZ, state.oam);
+	std::copy(m_framebuffer[0], m_framebuffer[0] + PPU_LCD_W * PPU_LCD_H, state.framebuffer[0]);
+	std::copy(m_framebuffer[1], m_framebuffer[1] + PPU_LCD_W * PPU_LCD_H, state.framebuffer[1]);
+	state.line = m_line;
+	state.clock = m_clock;
+	state.dma_cycles = m_dma_cycles;
+	state.frame = m_frame;
+	state.window_line = m_window_line;
+	state.oam_locked = m_oam->isLocked();
+	state.line_dirty = m_line_dirty;
+	state.frame_rendered = m_frame_rendered;
+	state.render_frame = m_render_frame;
+	copyRegisters(state, *this);
+}
+
+void PPU::loadState(const PPUState & state)
+{
+	sync();
+
+	// VRAM bypasses the tile versions, so every cached map tile goes stale
+	std::copy(state.vram, state.vram + PPU_VRAM_SZ, m_vram->getMemory());
+	for (int i = 0; i < PPU_MAPS; i++)
+	{
+		std::fill_n(m_map_tile[i], PPU_MAP_TILES * PPU_MAP_TILES, -1);
+	}
+
+	// OAM goes through load() to keep the line index up to date
+	m_oam->setSpriteHeight((state.LCDC & PPU_LCDC_OBJ_SZ) ? 16 : 8);
+	m_oam->load(state.oam);
+	m_oam->setLocked(state.oam_locked);
+
+	std::copy(state.framebuffer[0], state.framebuffer[0] + PPU_LCD_W * PPU_LCD_H, m_framebuffer[0]);
+	std::copy(state.framebuffer[1], state.framebuffer[1] + PPU_LCD_W * PPU_LCD_H, m_framebuffer[1]);
+	m_line = state.line;
+	m_clock = state.clock;
+	m_dma_cycles = state.dma_cycles;
+	m_frame = state.frame;
+	m_window_line = state.window_line;
+	m_line_dirty = state.line_dirty;
+	m_frame_rendered = state.frame_rendered;
+	m_render_frame = state.render_frame;
+	copyRegisters(*this, state);
+}
+
+void PPU::copyFrom(PPU & other)
+{
+	other.sync();
+	sync();
+
+	std::copy(other.m_vram->getMemory(), other.m_vram->getMemory() + PPU_VRAM_SZ, m_vram->getMemory());
+	for (int i = 0; i < PPU_MAPS; i++)
+	{
+		std::fill_n(m_map_tile[i], PPU_MAP_TILES * PPU_MAP_TILES, -1);
+	}
+
+	m_oam->setSpriteHeight((other.LCDC & PPU_LCDC_OBJ_SZ) ? 16 : 8);
+	m_oam->load(other.m_oam->getMemory());
+	m_oam->setLocked(other.m_oam->isLocked());
+
+	std::copy(other.m_framebuffer[0], other.m_framebuffer[0] + PPU_LCD_W * PPU_LCD_H, m_framebuffer[0]);
+	std::copy(other.m_framebuffer[1], other.m_framebuffer[1] + PPU_LCD_W * PPU_LCD_H, m_framebuffer[1]);
+	m_line = other.m_line;
+	m_clock = other.m_clock;
+	m_dma_cycles = other.m_dma_cycles;
+	m_frame = other.m_frame;
+	m_window_line = other.m_window_line;
+	m_line_dirty = other.m_line_dirty;
+	m_frame_rendered = other.m_frame_rendered;
+	m_render_frame = other.m_render_frame;
+	m_render_mode = other.m_render_mode;
+	m_render_interval = other.m_render_interval;
+	m_render_requested = other.m_render_requested;
+	copyRegisters(*this, other);
 }
 
 MemoryArea * PPU::getVRAM()
@@ -47,25 +319,354 @@ MemoryArea * PPU::getVRAM()
 	return m_vram;
 }
 
+OAM * PPU::getOAM()
+{
+	return m_oam;
+}
+
+const byte * PPU::getFramebuffer()
+{
+	return m_framebuffer[0];
+}
+
+unsigned PPU::getFrame()
+{
+	return m_frame;
+}
+
+bool PPU::isFrameRendered()
+{
+	return m_frame_rendered;
+}
+
+void PPU::setMode(byte mode)
+{
+	STAT = (STAT & ~PPU_STAT_MODE) | mode;
+
+	// Request STAT interrupt if enabled for the new mode
+	byte irq_enable = 0x00;
+	switch (mode)
+	{
+		case PPU_MODE_HBLANK: irq_enable = PPU_STAT_IRQ_HBLANK; break;
+		case PPU_MODE_VBLANK: irq_enable = PPU_STAT_IRQ_VBLANK; break;
+		case PPU_MODE_OAM: irq_enable = PPU_STAT_IRQ_OAM; break;
+	}
+
+	if (STAT & irq_enable)
+		m_irq.request(IRQ_STAT);
+}
+
+void PPU::setLY(byte ly)
+{
+	LY = ly;
+
+	// Update coincidence flag, request STAT interrupt on match if enabled
+	if (LY == LYC)
+	{
+		STAT |= PPU_STAT_LYC;
+
+		if (STAT & PPU_STAT_IRQ_LYC)
+			m_irq.request(IRQ_STAT);
+	}
+	else
+	{
+		STAT &= ~PPU_STAT_LYC;
+	}
+}
+
+void PPU::beginFrame()
+{
+	// Decide whether this frame produces pixels
+	switch (m_render_mode)
+	{
+		case RENDER_ALL:
+		{
+			m_render_frame = true;
+		} break;
+		case RENDER_EVERY_N:
+		{
+			m_render_frame = (m_frame % m_render_interval) == 0;
+		} break;
+		case RENDER_ON_DEMAND:
+		{
+			m_render_frame = m_render_requested;
+			m_render_requested = false;
+		} break;
+	}
+
+	m_window_line = 0;
+}
+
+void PPU::endFrame()
+{
+	// The back buffer must be complete before it is presented
+	sync();
+
+	// Present the finished frame, skipped frames leave the previous one in place
+	if (m_render_frame)
+		std::swap(m_framebuffer[0], m_framebuffer[1]);
+
+	m_frame_rendered = m_render_frame;
+	m_frame++;
+}
+
+void PPU::beginLine()
+{
+	// Sprite evaluation runs on every frame, rendered or not
+	m_line.sprite_count = m_oam->getLine(LY, m_line.sprites);
+
+	if (!m_render_frame)
+		return;
+
+	// Capture the registers this line is composed from
+	m_line.LY = LY;
+	m_line.LCDC = LCDC;
+	m_line.SCY = SCY;
+	m_line.SCX = SCX;
+	m_line.BGP = BGP;
+	m_line.OBP0 = OBP0;
+	m_line.OBP1 = OBP1;
+	m_line.WX = WX;
+	m_line.window_line = -1;
+
+	if ((LCDC & PPU_LCDC_BG) && (LCDC & PPU_LCDC_WIN) && LY >= WY && WX <= 166)
+		m_line.window_line = m_window_line++;
+
+	m_line_dirty = false;
+}
+
+void PPU::endLine()
+{
+	// Skipped frames keep the timing but produce no pixels
+	if (!m_render_frame)
+		return;
+
+	FrameTimerScope scope(m_frame_timer, FRAME_TIMER_PPU);
+
+	// Hand the line to the worker unless registers changed during mode 3
+	if (m_pipelined && !m_line_dirty && m_pipeline.push(m_line))
+	{
+		m_lines_queued++;
+		return;
+	}
+
+	// Synchronous fallback, composed from the current registers
+	sync();
+
+	m_line.LCDC = LCDC;
+	m_line.SCY = SCY;
+	m_line.SCX = SCX;
+	m_line.BGP = BGP;
+	m_line.OBP0 = OBP0;
+	m_line.OBP1 = OBP1;
+	m_line.WX = WX;
+
+	renderLine(m_line);
+}
+
+void PPU::renderLine(const PPULine & line)
+{
+	byte * pixels = m_framebuffer[1] + line.LY * PPU_LCD_W;
+
+	// BG & window disabled, line is blank
+	if ((line.LCDC & PPU_LCDC_BG) == 0)
+	{
+		std::fill_n(m_line_bg, PPU_LCD_W, 0x00);
+		std::fill_n(pixels, PPU_LCD_W, 0x00);
+	}
+	else
+	{
+		renderBackground(line);
+
+		if (line.window_line >= 0)
+			renderWindow(line);
+
+		// Map color indices through the BG palette
+		for (int x = 0; x < PPU_LCD_W; x++)
+		{
+			pixels[x] = (line.BGP >> (m_line_bg[x] << 1)) & 0x03;
+		}
+	}
+
+	if ((line.LCDC & PPU_LCDC_OBJ) && line.sprite_count > 0)
+		renderSprites(line, pixels);
+}
+
+void PPU::renderBackground(const PPULine & line)
+{
+	int map = (line.LCDC & PPU_LCDC_BG_MAP) ? 1 : 0;
+	int y = (line.LY + line.SCY) & 0xFF;
+	int x = line.SCX;
+
+	// Bring the tiles under this line up to date
+	updateMap(line.LCDC, map, y >> 3, x >> 3, ((x + PPU_LCD_W - 1) >> 3) - (x >> 3) + 1);
+
+	// Copy the visible 160 pixels, wrapping around the right edge of the map
+	const byte * row = m_map_cache[map] + y * PPU_MAP_SZ;
+	int first = std::min(PPU_MAP_SZ - x, PPU_LCD_W);
+
+	std::copy(row + x, row + x + first, m_line_bg);
+	std::copy(row, row + PPU_LCD_W - first, m_line_bg + first);
+}
+
+void PPU::renderWindow(const PPULine & line)
+{
+	int map = (line.LCDC & PPU_LCDC_WIN_MAP) ? 1 : 0;
+	int wx = line.WX - 7;
+	int start = std::max(wx, 0);
+	int px = start - wx;
+	int width = PPU_LCD_W - start;
+
+	updateMap(line.LCDC, map, line.window_line >> 3, px >> 3, ((px + width - 1) >> 3) - (px >> 3) + 1);
+
+	const byte * row = m_map_cache[map] + line.window_line * PPU_MAP_SZ;
+	std::copy(row + px, row + px + width, m_line_bg + start);
+}
+
+void PPU::renderSprites(const PPULine & line, byte * pixels)
+{
+	byte * vram = m_vram->getMemory();
+	byte * oam = m_oam->getMemory();
+	int height = (line.LCDC & PPU_LCDC_OBJ_SZ) ? 16 : 8;
+
+	// Sort by priority, lower x wins and OAM order breaks ties
+	byte order[OAM_LINE_MAX];
+	std::copy(line.sprites, line.sprites + line.sprite_count, order);
+	std::stable_sort(order, order + line.sprite_count, [oam](byte a, byte b) {
+		return oam[a * OAM_SPRITE_SZ + OAM_X] < oam[b * OAM_SPRITE_SZ + OAM_X];
+	});
+
+	// Pixels already owned by a higher priority sprite
+	bool owned[PPU_LCD_W] = {};
+
+	for (int s = 0; s < line.sprite_count; s++)
+	{
+		byte * sprite = &oam[order[s] * OAM_SPRITE_SZ];
+		int x = sprite[OAM_X] - 8;
+		int row = line.LY - (sprite[OAM_Y] - 16);
+		byte tile = sprite[OAM_TILE];
+		byte flags = sprite[OAM_FLAGS];
+		byte palette = (flags & OAM_FLAG_PALETTE) ? line.OBP1 : line.OBP0;
+
+		if (flags & OAM_FLAG_YFLIP)
+			row = height - 1 - row;
+
+		if (height == 16)
+			tile &= 0xFE;
+
+		word addr = static_cast<word>((tile << 4) + (row << 1));
+		byte lo = vram[addr];
+		byte hi = vram[addr + 1];
+
+		for (int i = 0; i < 8; i++)
+		{
+			int px = x + i;
+			if (px < 0 || px >= PPU_LCD_W || owned[px])
+				continue;
+
+			int bit = (flags & OAM_FLAG_XFLIP) ? i : 7 - i;
+			byte color = static_cast<byte>((((hi >> bit) & 0x01) << 1) | ((lo >> bit) & 0x01));
+
+			// Color 0 is transparent
+			if (color == 0)
+				continue;
+
+			owned[px] = true;
+
+			// Hidden behind non-zero bg, but still hides lower priority sprites
+			if ((flags & OAM_FLAG_PRIORITY) && m_line_bg[px] != 0)
+				continue;
+
+			pixels[px] = (palette >> (color << 1)) & 0x03;
+		}
+	}
+}
+
+void PPU::updateMap(byte lcdc, int map, int ty, int tx, int count)
+{
+	const byte * entries = m_vram->getMemory() + 0x1800 + map * 0x0400 + ty * PPU_MAP_TILES;
+
+	for (int i = 0; i < count; i++)
+	{
+		int x = (tx + i) & (PPU_MAP_TILES - 1);
+
+		// 0x8000 addressing uses unsigned tile numbers, 0x8800 signed ones around 0x9000
+		int tile = (lcdc & PPU_LCDC_TILES) ? entries[x] : 256 + static_cast<int8_t>(entries[x]);
+		unsigned version = m_vram->getTileVersion(tile);
+
+		// Redraw if the map entry now points elsewhere or the tile data changed
+		int cell = ty * PPU_MAP_TILES + x;
+		if (m_map_tile[map][cell] != tile || m_map_version[map][cell] != version)
+		{
+			drawTile(map, x, ty, tile);
+			m_map_tile[map][cell] = tile;
+			m_map_version[map][cell] = version;
+		}
+	}
+}
+
+void PPU::drawTile(int map, int tx, int ty, int tile)
+{
+	const byte * data = m_vram->getMemory() + (tile << 4);
+	byte * pixels = m_map_cache[map] + (ty << 3) * PPU_MAP_SZ + (tx << 3);
+
+	for (int y = 0; y < 8; y++, pixels += PPU_MAP_SZ)
+	{
+		byte lo = data[y << 1];
+		byte hi = data[(y << 1) + 1];
+
+		for (int i = 0; i < 8; i++)
+		{
+			int bit = 7 - i;
+			pixels[i] = static_cast<byte>((((hi >> bit) & 0x01) << 1) | ((lo >> bit) & 0x01));
+		}
+	}
+}
+
+void PPU::work()
+{
+	PPULine line;
+	int idle = 0;
+
+	while (m_worker_running.load(std::memory_order_acquire))
+	{
+		if (m_pipeline.pop(line))
+		{
+			renderLine(line);
+			m_lines_done.fetch_add(1, std::memory_order_release);
+			idle = 0;
+		}
+		// Back off while the CPU is in vblank or the LCD is off
+		else if (++idle < 1024)
+		{
+			std::this_thread::yield();
+		}
+		else
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds(50));
+		}
+	}
+}
+
 byte PPU::read(word addr)
 {
 	switch (addr)
 	{
 		case PPU_REG_LCDC:
 		{
-
+			return LCDC;
 		} break;
 		case PPU_REG_STAT:
 		{
-
+			return STAT | 0x80;
 		} break;
 		case PPU_REG_SCY:
 		{
-
+			return SCY;
 		} break;
 		case PPU_REG_SCX:
 		{
-
+			return SCX;
 		} break;
 		case PPU_REG_LY:
 		{
@@ -73,31 +674,31 @@ byte PPU::read(word addr)
 		} break;
 		case PPU_REG_LYC:
 		{
-
+			return LYC;
 		} break;
 		case PPU_REG_DMA:
 		{
-
+			return DMA;
 		} break;
 		case PPU_REG_BGP:
 		{
-
+			return BGP;
 		} break;
 		case PPU_REG_OBP0:
 		{
-
+			return OBP0;
 		} break;
 		case PPU_REG_OBP1:
 		{
-
+			return OBP1;
 		} break;
 		case PPU_REG_WY:
 		{
-
+			return WY;
 		} break;
 		case PPU_REG_WX:
 		{
-
+			return WX;
 		} break;
 	}
 
@@ -106,23 +707,47 @@ byte PPU::read(word addr)
 
 void PPU::write(word addr, byte value)
 {
+	// Registers changed during mode 3, the captured line is stale
+	if ((STAT & PPU_STAT_MODE) == PPU_MODE_TRANSFER)
+		m_line_dirty = true;
+
 	switch (addr)
 	{
 		case PPU_REG_LCDC:
 		{
-
+			bool was_on = (LCDC & PPU_LCDC_ON) != 0;
+			LCDC = value;
+
+			m_oam->setSpriteHeight((LCDC & PPU_LCDC_OBJ_SZ) ? 16 : 8);
+
+			// LCD switched off, LY resets and the PPU idles in mode 0
+			if (was_on && (LCDC & PPU_LCDC_ON) == 0)
+			{
+				m_clock = 0;
+				LY = 0;
+				STAT &= ~PPU_STAT_MODE;
+			}
+			// LCD switched on, start a new frame from line 0
+			else if (!was_on && (LCDC & PPU_LCDC_ON) != 0)
+			{
+				m_clock = 0;
+				setLY(0);
+				beginFrame();
+				STAT = (STAT & ~PPU_STAT_MODE) | PPU_MODE_OAM;
+			}
 		} break;
 		case PPU_REG_STAT:
 		{
-
+			// Only the interrupt enable bits are writable
+			STAT = (STAT & 0x07) | (value & 0x78);
 		} break;
 		case PPU_REG_SCY:
 		{
-
+			SCY = value;
 		} break;
 		case PPU_REG_SCX:
 		{
-
+			SCX = value;
 		} break;
 		case PPU_REG_LY:
 		{
@@ -130,31 +755,35 @@ void PPU::write(word addr, byte value)
 		} break;
 		case PPU_REG_LYC:
 		{
-
+			LYC = value;
 		} break;
 		case PPU_REG_DMA:
 		{
-
+			// Lock OAM until the transfer would have finished
+			sync();
+			DMA = value;
+			m_dma_cycles = PPU_CYCLES_DMA;
+			m_oam->setLocked(true);
 		} break;
 		case PPU_REG_BGP:
 		{
-
+			BGP = value;
 		} break;
 		case PPU_REG_OBP0:
 		{
-
+			OBP0 = value;
 		} break;
 		case PPU_REG_OBP1:
 		{
-
+			OBP1 = value;
 		} break;
 		case PPU_REG_WY:
 		{
-
+			WY = value;
 		} break;
 		case PPU_REG_WX:
 		{
-
+			WX = value;
 		} break;
 	}
 }
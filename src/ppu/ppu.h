@@ -1,7 +1,11 @@
 #ifndef PPU_H
 #define PPU_H
 
+#include <atomic>
+#include <thread>
 #include "mem/memory_area.h"
+#include "mem/oam.h"
+#include "util/spsc_queue.h"
 
 namespace hgb
 {
@@ -25,21 +29,213 @@ namespace hgb
 #define PPU_REG_WY		0xFF4A	// window y position (R/W)
 #define PPU_REG_WX		0xFF4B	// window x position minus 7 (R/W)
 
+// LCD dimensions
+#define PPU_LCD_W		160		// lcd width in pixels
+#define PPU_LCD_H		144		// lcd height in pixels, vblank starts after this line
+#define PPU_LINES		154		// scanlines per frame, including vblank
+
+// Mode lengths in clock cycles
+#define PPU_CYCLES_OAM		80	// mode 2, oam search
+#define PPU_CYCLES_TRANSFER	172	// mode 3, pixel transfer
+#define PPU_CYCLES_HBLANK	204	// mode 0, hblank
+#define PPU_CYCLES_LINE		456	// one full scanline
+#define PPU_CYCLES_DMA		640	// oam dma bus lock, 160 machine cycles
+#define PPU_CYCLES_FRAME	70224	// one full frame, PPU_CYCLES_LINE * PPU_LINES
+
+// LCDC bits
+#define PPU_LCDC_BG		0x01	// bg display enable
+#define PPU_LCDC_OBJ	0x02	// obj display enable
+#define PPU_LCDC_OBJ_SZ	0x04	// obj size (0: 8x8, 1: 8x16)
+#define PPU_LCDC_BG_MAP	0x08	// bg tile map select (0: 0x9800, 1: 0x9C00)
+#define PPU_LCDC_TILES	0x10	// bg & window tile data select (0: 0x8800, 1: 0x8000)
+#define PPU_LCDC_WIN	0x20	// window display enable
+#define PPU_LCDC_WIN_MAP	0x40	// window tile map select (0: 0x9800, 1: 0x9C00)
+#define PPU_LCDC_ON		0x80	// lcd display enable
+
+// STAT bits
+#define PPU_STAT_MODE		0x03	// current mode
+#define PPU_STAT_LYC		0x04	// LY == LYC coincidence flag
+#define PPU_STAT_IRQ_HBLANK	0x08	// mode 0 interrupt enable
+#define PPU_STAT_IRQ_VBLANK	0x10	// mode 1 interrupt enable
+#define PPU_STAT_IRQ_OAM	0x20	// mode 2 interrupt enable
+#define PPU_STAT_IRQ_LYC	0x40	// LY == LYC interrupt enable
+
+// PPU modes
+#define PPU_MODE_HBLANK		0x00
+#define PPU_MODE_VBLANK		0x01
+#define PPU_MODE_OAM		0x02
+#define PPU_MODE_TRANSFER	0x03
+
+// Scanlines the render worker may lag behind
+#define PPU_PIPELINE_SZ		32
+
+// Prerendered bg tile maps
+#define PPU_MAPS			2		// 0x9800 & 0x9C00
+#define PPU_MAP_TILES		32		// tiles per map row & column
+#define PPU_MAP_SZ			256		// map width & height in pixels
+
+class FrameTimer;
+class IRQ;
+class VRAM;
+
+// Register state a scanline is composed from, captured when mode 3 starts
+struct PPULine
+{
+	byte LY;
+	byte LCDC;
+	byte SCY;
+	byte SCX;
+	byte BGP;
+	byte OBP0;
+	byte OBP1;
+	byte WX;
+	// Internal window line counter, -1 if the window is not on this line
+	int window_line;
+	byte sprites[OAM_LINE_MAX];
+	int sprite_count;
+};
+
+// Savestate image, includes VRAM, OAM & both framebuffers so a frame in progress resumes exactly
+struct PPUState
+{
+	byte vram[PPU_VRAM_SZ];
+	byte oam[OAM_SZ];
+	byte framebuffer[2][PPU_LCD_W * PPU_LCD_H];
+	PPULine line;
+	int clock;
+	int dma_cycles;
+	unsigned frame;
+	int window_line;
+	bool oam_locked;
+	bool line_dirty;
+	bool frame_rendered;
+	bool render_frame;
+	byte LCDC;
+	byte STAT;
+	byte SCY;
+	byte SCX;
+	byte LY;
+	byte LYC;
+	byte DMA;
+	byte BGP;
+	byte OBP0;
+	byte OBP1;
+	byte WY;
+	byte WX;
+};
+
 class PPU : public MemoryArea
 {
 public:
-	PPU();
+	enum RenderMode_t
+	{
+		RENDER_ALL = 0,			// produce pixels for every frame
+		RENDER_EVERY_N = 1,		// produce pixels for every n:th frame only
+		RENDER_ON_DEMAND = 2	// produce pixels only for frames asked with requestFrame()
+	};
+
+	PPU(
+		IRQ & irq
+	);
 	~PPU();
 
-	// Run the PPU, one cycle at a time
-	void tick();
+	// Run the PPU for the given amount of clock cycles
+	void tick(int cycles);
+	// Choose which frames produce pixels, timing and interrupts are unaffected
+	void setRenderMode(RenderMode_t mode, int interval = 1);
+	// Produce pixels for the next frame that starts (RENDER_ON_DEMAND)
+	void requestFrame();
+	// Compose scanlines on a worker thread while the CPU runs ahead
+	void setPipelined(bool pipelined);
+	// Wait until the worker has composed every queued scanline
+	void flush();
+	// Time scanline composition into timer, NULL turns timing off
+	void setFrameTimer(FrameTimer * frame_timer);
+
+	void saveState(PPUState & state);
+	// Render mode & pipelining are host settings and stay as they are
+	void loadState(const PPUState & state);
+	// Become an exact copy of another PPU, VRAM, OAM & framebuffers are copied outright
+	void copyFrom(PPU & other);
+
+	// Called before VRAM/OAM changes, queued scanlines must see the old contents
+	inline void sync()
+	{
+		if (m_pipelined)
+			flush();
+	}
 
 	MemoryArea * getVRAM();
+	OAM * getOAM();
+	// Last rendered frame, PPU_LCD_W * PPU_LCD_H shades (0-3)
+	const byte * getFramebuffer();
+	// # of frames completed since power on
+	unsigned getFrame();
+	// Did the last completed frame produce pixels
+	bool isFrameRendered();
 
 	virtual byte read(word addr) override;
 	virtual void write(word addr, byte value) override;
 private:
-	MemoryArea * m_vram;
+	void setMode(byte mode);
+	void setLY(byte ly);
+	void beginFrame();
+	void endFrame();
+	void beginLine();
+	void endLine();
+	void renderLine(const PPULine & line);
+	void renderBackground(const PPULine & line);
+	void renderWindow(const PPULine & line);
+	void renderSprites(const PPULine & line, byte * pixels);
+	void updateMap(byte lcdc, int map, int ty, int tx, int count);
+	void drawTile(int map, int tx, int ty, int tile);
+	void work();
+
+	// LCD registers share their names between the PPU & PPUState
+	template <typename D, typename S>
+	static void copyRegisters(D & dst, const S & src)
+	{
+		dst.LCDC = src.LCDC;
+		dst.STAT = src.STAT;
+		dst.SCY = src.SCY;
+		dst.SCX = src.SCX;
+		dst.LY = src.LY;
+		dst.LYC = src.LYC;
+		dst.DMA = src.DMA;
+		dst.BGP = src.BGP;
+		dst.OBP0 = src.OBP0;
+		dst.OBP1 = src.OBP1;
+		dst.WY = src.WY;
+		dst.WX = src.WX;
+	}
+
+	IRQ & m_irq;
+	VRAM * m_vram;
+	OAM * m_oam;
+	// Bg maps as 256x256 color indices, redrawn per tile when stale
+	byte * m_map_cache[PPU_MAPS];
+	int m_map_tile[PPU_MAPS][PPU_MAP_TILES * PPU_MAP_TILES];
+	unsigned m_map_version[PPU_MAPS][PPU_MAP_TILES * PPU_MAP_TILES];
+	byte * m_framebuffer[2];
+	byte m_line_bg[PPU_LCD_W];
+	PPULine m_line;
+	bool m_line_dirty;
+	bool m_pipelined;
+	SPSCQueue<PPULine, PPU_PIPELINE_SZ> m_pipeline;
+	unsigned m_lines_queued;
+	std::atomic<unsigned> m_lines_done;
+	std::atomic<bool> m_worker_running;
+	std::thread m_worker;
+	int m_clock;
+	int m_dma_cycles;
+	unsigned m_frame;
+	bool m_frame_rendered;
+	bool m_render_frame;
+	RenderMode_t m_render_mode;
+	int m_render_interval;
+	bool m_render_requested;
+	int m_window_line;
+	FrameTimer * m_frame_timer;
 	byte LCDC;
 	byte STAT;
 	byte SCY;
@@ -0,0 +1,92 @@
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+#include "cpu/trace.h"
+
+static void printRecord(const char * prefix, const hgb::TraceRecord & r)
+{
+	printf("%s%10llu %04X: %02X %02X %02X  AF=%04X BC=%04X DE=%04X HL=%04X SP=%04X\n",
+		   prefix, static_cast<unsigned long long>(r.cycle), r.PC, r.op[0], r.op[1], r.op[2], r.AF, r.BC, r.DE, r.HL, r.SP);
+}
+
+static bool equal(const hgb::TraceRecord & a, const hgb::TraceRecord & b)
+{
+	return a.cycle == b.cycle && a.PC == b.PC && a.AF == b.AF && a.BC == b.BC && a.DE == b.DE && a.HL == b.HL && a.SP == b.SP &&
+		   a.op[0] == b.op[0] && a.op[1] == b.op[1] && a.op[2] == b.op[2];
+}
+
+// Compare two traces from the first cycle both contain, prints the first divergence with the instructions leading to it
+static int diff(const std::vector<hgb::TraceRecord> & a, const std::vector<hgb::TraceRecord> & b, size_t context)
+{
+	size_t i = 0, j = 0;
+	while (i < a.size() && j < b.size() && a[i].cycle != b[j].cycle)
+	{
+		if (a[i].cycle < b[j].cycle)
+			i++;
+		else
+			j++;
+	}
+
+	if (i == a.size() || j == b.size())
+	{
+		printf("no common cycle, the traces do not overlap\n");
+		return 2;
+	}
+
+	size_t start = i;
+	for (; i < a.size() && j < b.size(); i++, j++)
+	{
+		if (equal(a[i], b[j]))
+			continue;
+
+		printf("diverged after %zu matching instructions\n", i - start);
+		for (size_t k = (i - start > context) ? i - context : start; k < i; k++)
+		{
+			printRecord("  ", a[k]);
+		}
+		printRecord("- ", a[i]);
+		printRecord("+ ", b[j]);
+
+		return 1;
+	}
+
+	printf("identical over %zu instructions\n", i - start);
+
+	return 0;
+}
+
+// Prints a binary instruction trace, or diffs two of them
+int main(int argc, char * argv[])
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "usage: %s <trace> [other trace] [context]\n", argv[0]);
+		return 1;
+	}
+
+	try
+	{
+		std::vector<hgb::TraceRecord> a = hgb::Trace::load(argv[1]);
+
+		if (argc < 3)
+		{
+			for (const hgb::TraceRecord & r : a)
+			{
+				printRecord("", r);
+			}
+
+			return 0;
+		}
+
+		std::vector<hgb::TraceRecord> b = hgb::Trace::load(argv[2]);
+		size_t context = (argc > 3) ? strtoul(argv[3], NULL, 10) : 8;
+
+		return diff(a, b, context);
+	}
+	catch (const std::exception & e)
+	{
+		fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+}
@@ -0,0 +1,477 @@
+#include "async_log.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "util/spsc_queue.h"
+
+namespace hgb
+{
+
+// Binary log entry tags
+#define ASYNC_LOG_TAG_SITE		0x53	// 'S', call site seen for the first time
+#define ASYNC_LOG_TAG_RECORD	0x52	// 'R', one message
+
+namespace
+{
+
+// Ring of one logging thread, kept until drained after the thread exits
+struct Producer
+{
+	SPSCQueue<AsyncLogRecord, ASYNC_LOG_RING_SZ> ring;
+	std::atomic<uint64_t> dropped;
+	std::atomic<bool> retired;
+	uint32_t thread;
+};
+
+std::mutex s_lock;
+std::vector<Producer *> s_producers;
+uint32_t s_threads = 0;
+std::atomic<bool> s_running(false);
+std::atomic<bool> s_stopping(false);
+std::thread s_worker;
+AsyncLog::Sink_t s_sink = AsyncLog::SINK_TEXT;
+FILE * s_file = NULL;
+uint64_t s_start = 0;
+double s_ns_per_tick = 1.0;
+// Written by the background thread, read from any
+std::atomic<uint64_t> s_dropped(0);
+
+// Registers the ring of the calling thread on first use, retires it when the thread exits
+struct ThreadProducer
+{
+	Producer * producer = NULL;
+
+	Producer * get()
+	{
+		if (producer == NULL)
+		{
+			producer = new Producer();
+			producer->dropped = 0;
+			producer->retired = false;
+
+			std::lock_guard<std::mutex> guard(s_lock);
+			producer->thread = s_threads++;
+			s_producers.push_back(producer);
+		}
+
+		return producer;
+	}
+
+	~ThreadProducer()
+	{
+		if (producer != NULL)
+			producer->retired.store(true, std::memory_order_release);
+	}
+};
+
+thread_local ThreadProducer t_producer;
+
+struct Entry
+{
+	AsyncLogRecord record;
+	uint32_t thread;
+};
+
+template <typename T>
+void writeValue(FILE * file_ptr, T value)
+{
+	fwrite(&value, sizeof(value), 1, file_ptr);
+}
+
+template <typename T>
+bool readValue(FILE * file_ptr, T & value)
+{
+	return fread(&value, sizeof(value), 1, file_ptr) == 1;
+}
+
+void writeString(FILE * file_ptr, const char * str)
+{
+	uint32_t len = static_cast<uint32_t>(strlen(str));
+	writeValue(file_ptr, len);
+	fwrite(str, len, 1, file_ptr);
+}
+
+bool readString(FILE * file_ptr, std::string & str)
+{
+	uint32_t len;
+	if (!readValue(file_ptr, len))
+		return false;
+
+	str.resize(len);
+
+	return len == 0 || fread(&str[0], len, 1, file_ptr) == 1;
+}
+
+const char * levelName(int level)
+{
+	switch (level)
+	{
+		case MLIBC_LOG_LEVEL_DBG: return "DBG";
+		case MLIBC_LOG_LEVEL_INF: return "INF";
+		case MLIBC_LOG_LEVEL_WRN: return "WRN";
+		case MLIBC_LOG_LEVEL_ERR: return "ERR";
+	}
+
+	return "???";
+}
+
+// Site ids of the binary file, only touched by the background thread
+std::unordered_map<const AsyncLogSite *, uint32_t> s_sites;
+
+void writeRecord(const Entry & entry)
+{
+	const AsyncLogRecord & record = entry.record;
+
+	if (s_sink == AsyncLog::SINK_TEXT)
+	{
+		char text[1024];
+		AsyncLog::format(record, text, sizeof(text));
+		mlibc_log(record.site->level, "%s", text);
+		return;
+	}
+
+	auto site = s_sites.find(record.site);
+	if (site == s_sites.end())
+	{
+		site = s_sites.emplace(record.site, static_cast<uint32_t>(s_sites.size())).first;
+
+		writeValue(s_file, static_cast<byte>(ASYNC_LOG_TAG_SITE));
+		writeValue(s_file, site->second);
+		writeValue(s_file, static_cast<int32_t>(record.site->level));
+		writeValue(s_file, static_cast<int32_t>(record.site->line));
+		writeString(s_file, record.site->format);
+		writeString(s_file, record.site->file);
+	}
+
+	writeValue(s_file, static_cast<byte>(ASYNC_LOG_TAG_RECORD));
+	writeValue(s_file, site->second);
+	writeValue(s_file, entry.thread);
+	writeValue(s_file, record.timestamp);
+	writeValue(s_file, record.count);
+	fwrite(record.types, record.count, 1, s_file);
+	fwrite(record.args, sizeof(uint64_t), record.count, s_file);
+	fwrite(record.text, sizeof(record.text), 1, s_file);
+}
+
+// Drain every ring once, returns # of records written
+size_t drain()
+{
+	std::vector<Producer *> producers;
+	{
+		std::lock_guard<std::mutex> guard(s_lock);
+		producers = s_producers;
+	}
+
+	std::vector<Entry> entries;
+	Entry entry;
+
+	for (Producer * producer : producers)
+	{
+		// Read before popping, a retired ring is final once it is empty
+		bool retired = producer->retired.load(std::memory_order_acquire);
+
+		entry.thread = producer->thread;
+		while (producer->ring.pop(entry.record))
+		{
+			uint64_t ticks = (entry.record.timestamp > s_start) ? entry.record.timestamp - s_start : 0;
+			entry.record.timestamp = static_cast<uint64_t>(ticks * s_ns_per_tick);
+			entries.push_back(entry);
+		}
+
+		s_dropped.fetch_add(producer->dropped.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+
+		if (retired)
+		{
+			std::lock_guard<std::mutex> guard(s_lock);
+			s_producers.erase(std::find(s_producers.begin(), s_producers.end(), producer));
+			delete producer;
+		}
+	}
+
+	// Threads are drained one after another, put their records back in time order
+	std::stable_sort(entries.begin(), entries.end(), [](const Entry & a, const Entry & b)
+	{
+		return a.record.timestamp < b.record.timestamp;
+	});
+
+	for (const Entry & e : entries)
+	{
+		writeRecord(e);
+	}
+
+	return entries.size();
+}
+
+void work()
+{
+	for (;;)
+	{
+		bool stopping = s_stopping.load(std::memory_order_acquire);
+
+		if (drain() == 0)
+		{
+			if (stopping)
+				break;
+
+			std::this_thread::sleep_for(std::chrono::microseconds(ASYNC_LOG_IDLE_US));
+		}
+	}
+
+	if (s_file != NULL)
+		fflush(s_file);
+}
+
+// A logger left running is stopped before the statics above go away
+struct Shutdown
+{
+	~Shutdown()
+	{
+		AsyncLog::stop();
+	}
+} s_shutdown;
+
+}
+
+void AsyncLog::start(Sink_t sink, const std::string & fp)
+{
+	if (isRunning())
+		throw std::runtime_error("AsyncLog::start(...), error! Already running!");
+
+	if (sink == SINK_BINARY)
+	{
+		s_file = fopen(fp.c_str(), "wb");
+
+		if (s_file == NULL)
+			throw std::runtime_error("AsyncLog::start(...), error! fopen returned a NULL pointer!");
+
+		writeValue(s_file, static_cast<uint32_t>(ASYNC_LOG_MAGIC));
+		writeValue(s_file, static_cast<uint32_t>(ASYNC_LOG_VERSION));
+	}
+
+	s_sink = sink;
+	s_sites.clear();
+	s_dropped.store(0, std::memory_order_relaxed);
+	// Ticks to nanoseconds
+	s_ns_per_tick = cycleClockNs();
+	s_start = now();
+	s_stopping = false;
+	s_worker = std::thread(work);
+	s_running.store(true, std::memory_order_release);
+
+	mlibc_dbg("AsyncLog::start(sink:%d, fp:%s)", sink, fp.c_str());
+}
+
+void AsyncLog::stop()
+{
+	if (!isRunning())
+		return;
+
+	// Late records from other threads still land in their rings and are drained below
+	s_running.store(false, std::memory_order_release);
+	s_stopping.store(true, std::memory_order_release);
+	s_worker.join();
+
+	if (s_file != NULL)
+	{
+		fclose(s_file);
+		s_file = NULL;
+	}
+
+	mlibc_dbg("AsyncLog::stop(). dropped: %llu", static_cast<unsigned long long>(s_dropped.load(std::memory_order_relaxed)));
+}
+
+bool AsyncLog::isRunning()
+{
+	return s_running.load(std::memory_order_acquire);
+}
+
+uint64_t AsyncLog::getDropped()
+{
+	return s_dropped.load(std::memory_order_relaxed);
+}
+
+void AsyncLog::push(const AsyncLogRecord & record)
+{
+	Producer * producer = t_producer.get();
+
+	if (!producer->ring.push(record))
+		producer->dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+int AsyncLog::format(const AsyncLogRecord & record, char * dst, size_t size)
+{
+	const char * src = record.site->format;
+	size_t used = 0;
+	int arg = 0;
+
+	auto append = [&](int n)
+	{
+		if (n > 0)
+			used = std::min(used + static_cast<size_t>(n), size - 1);
+	};
+
+	dst[0] = '\0';
+
+	while (*src != '\0' && used < size - 1)
+	{
+		if (*src != '%')
+		{
+			dst[used++] = *src++;
+			dst[used] = '\0';
+			continue;
+		}
+
+		if (src[1] == '%')
+		{
+			dst[used++] = '%';
+			dst[used] = '\0';
+			src += 2;
+			continue;
+		}
+
+		// Flags, width & precision are kept, the length modifier is replaced to match the stored argument
+		char spec[32];
+		size_t n = 0;
+		spec[n++] = *src++;
+
+		while (*src != '\0' && strchr("-+ #0123456789.", *src) != NULL && n < sizeof(spec) - 4)
+		{
+			spec[n++] = *src++;
+		}
+		while (*src != '\0' && strchr("hljztL", *src) != NULL)
+		{
+			src++;
+		}
+
+		char conversion = *src;
+		if (conversion == '\0')
+			break;
+		src++;
+
+		if (arg >= record.count)
+		{
+			append(snprintf(dst + used, size - used, "<?>"));
+			continue;
+		}
+
+		byte type = record.types[arg];
+		uint64_t value = record.args[arg++];
+
+		if (strchr("diouxXc", conversion) != NULL)
+		{
+			if (conversion != 'c')
+			{
+				spec[n++] = 'l';
+				spec[n++] = 'l';
+			}
+			spec[n++] = conversion;
+			spec[n] = '\0';
+
+			if (conversion == 'c')
+				append(snprintf(dst + used, size - used, spec, static_cast<int>(value)));
+			else if (type == AsyncLogRecord::ARG_INT)
+				append(snprintf(dst + used, size - used, spec, static_cast<long long>(value)));
+			else
+				append(snprintf(dst + used, size - used, spec, static_cast<unsigned long long>(value)));
+		}
+		else if (strchr("eEfFgGaA", conversion) != NULL)
+		{
+			double d;
+			std::memcpy(&d, &value, sizeof(d));
+
+			spec[n++] = conversion;
+			spec[n] = '\0';
+			append(snprintf(dst + used, size - used, spec, d));
+		}
+		else if (conversion == 's')
+		{
+			spec[n++] = 's';
+			spec[n] = '\0';
+
+			const char * str = (type == AsyncLogRecord::ARG_STR && value < ASYNC_LOG_TEXT_SZ) ? record.text + value : "";
+			append(snprintf(dst + used, size - used, spec, str));
+		}
+		else if (conversion == 'p')
+		{
+			append(snprintf(dst + used, size - used, "0x%llx", static_cast<unsigned long long>(value)));
+		}
+	}
+
+	return static_cast<int>(used);
+}
+
+void AsyncLog::decode(const std::string & fp, FILE * out)
+{
+	std::unique_ptr<FILE, int(*)(FILE *)> file(fopen(fp.c_str(), "rb"), fclose);
+
+	if (!file)
+		throw std::runtime_error("AsyncLog::decode(...), error! fopen returned a NULL pointer!");
+
+	uint32_t magic, version;
+	if (!readValue(file.get(), magic) || !readValue(file.get(), version) || magic != ASYNC_LOG_MAGIC || version != ASYNC_LOG_VERSION)
+		throw std::runtime_error("AsyncLog::decode(...), error! Not a binary log of this version!");
+
+	// Sites own the strings the decoded records point to
+	struct Site
+	{
+		AsyncLogSite site;
+		std::string format;
+		std::string file;
+	};
+	std::vector<std::unique_ptr<Site>> sites;
+
+	byte tag;
+	while (readValue(file.get(), tag))
+	{
+		if (tag == ASYNC_LOG_TAG_SITE)
+		{
+			std::unique_ptr<Site> site(new Site());
+			uint32_t id;
+			int32_t level, line;
+
+			if (!readValue(file.get(), id) || !readValue(file.get(), level) || !readValue(file.get(), line) ||
+				!readString(file.get(), site->format) || !readString(file.get(), site->file) || id != sites.size())
+				break;
+
+			site->site = { static_cast<mlibc_log_level_t>(level), site->format.c_str(), site->file.c_str(), line };
+			sites.push_back(std::move(site));
+		}
+		else if (tag == ASYNC_LOG_TAG_RECORD)
+		{
+			AsyncLogRecord record;
+			uint32_t id, thread;
+
+			if (!readValue(file.get(), id) || !readValue(file.get(), thread) || !readValue(file.get(), record.timestamp) ||
+				!readValue(file.get(), record.count) || id >= sites.size() || record.count > ASYNC_LOG_ARGS ||
+				fread(record.types, 1, record.count, file.get()) != record.count ||
+				fread(record.args, sizeof(uint64_t), record.count, file.get()) != record.count ||
+				fread(record.text, sizeof(record.text), 1, file.get()) != 1)
+				break;
+
+			record.site = &sites[id]->site;
+
+			char text[1024];
+			format(record, text, sizeof(text));
+			fprintf(out, "%.6f T%u %s | %s (%s:%d)\n",
+					record.timestamp / 1e9,
+					thread,
+					levelName(record.site->level),
+					text,
+					record.site->file,
+					record.site->line
+			);
+		}
+		else
+		{
+			throw std::runtime_error("AsyncLog::decode(...), error! Corrupt binary log!");
+		}
+	}
+}
+
+}
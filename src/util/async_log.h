@@ -0,0 +1,174 @@
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include "3rdparty/mlibc_log.h"
+#include "data_types.h"
+#include "util/cycle_clock.h"
+
+namespace hgb
+{
+
+#define ASYNC_LOG_RING_SZ	1024		// records per producer thread, power of two
+#define ASYNC_LOG_ARGS		8			// arguments per record, the rest are dropped
+#define ASYNC_LOG_TEXT_SZ	32			// bytes for string arguments per record, longer ones are cut
+#define ASYNC_LOG_IDLE_US	1000		// background thread sleep when every ring is empty
+#define ASYNC_LOG_MAGIC		0x474C4748	// "HGLG"
+#define ASYNC_LOG_VERSION	1
+
+// One per call site, static so records only carry a pointer to it
+struct AsyncLogSite
+{
+	mlibc_log_level_t level;
+	const char * format;
+	const char * file;
+	int line;
+};
+
+// Compact binary record, arguments are kept raw and formatted later
+struct AsyncLogRecord
+{
+	enum Arg_t
+	{
+		ARG_INT = 0,
+		ARG_UINT = 1,
+		ARG_DOUBLE = 2,
+		ARG_PTR = 3,
+		ARG_STR = 4		// args[] holds the offset into text, past the end when it did not fit
+	};
+
+	const AsyncLogSite * site;
+	// Raw clock ticks when queued, nanoseconds since the logger started once drained
+	uint64_t timestamp;
+	uint64_t args[ASYNC_LOG_ARGS];
+	byte types[ASYNC_LOG_ARGS];
+	byte count;
+	char text[ASYNC_LOG_TEXT_SZ];
+};
+
+// Process wide asynchronous backend for mlibc_log style messages.
+// Every logging thread gets its own lock-free ring, a background thread drains them and either formats the records
+// through mlibc_log or writes them to a binary file for hgb_logdump. A full ring drops records instead of blocking.
+// Not running, messages are formatted synchronously with mlibc_log as before.
+class AsyncLog
+{
+public:
+	enum Sink_t
+	{
+		SINK_TEXT = 0,		// format on the background thread, print with mlibc_log
+		SINK_BINARY = 1		// raw records to a file, decode with AsyncLog::decode()
+	};
+
+	// Start the background thread, throws if the binary file cannot be created
+	static void start(Sink_t sink, const std::string & fp = "");
+	// Drain every ring & join the background thread
+	static void stop();
+	static bool isRunning();
+	// Records lost to full rings since start, safe to call while running
+	static uint64_t getDropped();
+
+	// Format the records of a binary log as text lines
+	static void decode(const std::string & fp, FILE * out);
+	// printf a single record, arguments are converted to what each conversion expects
+	static int format(const AsyncLogRecord & record, char * dst, size_t size);
+
+	template <typename... Args>
+	static void log(const AsyncLogSite & site, Args... args)
+	{
+		if (!isRunning())
+		{
+			mlibc_log(site.level, site.format, args...);
+			return;
+		}
+
+		AsyncLogRecord record;
+		record.site = &site;
+		record.timestamp = now();
+		record.count = 0;
+		// Written out whole, no stack garbage in the binary log
+		std::memset(record.text, 0, sizeof(record.text));
+
+		size_t text = 0;
+		int expand[] = { 0, (pack(record, text, args), 0)... };
+		(void)expand;
+
+		push(record);
+	}
+private:
+	// Time stamp counter where there is one, a clock read costs more than the rest of the record
+	static inline uint64_t now()
+	{
+		return cycleClock();
+	}
+
+	static void push(const AsyncLogRecord & record);
+
+	template <typename T>
+	static void pack(AsyncLogRecord & record, size_t & text, T value)
+	{
+		if (record.count == ASYNC_LOG_ARGS)
+			return;
+
+		byte & type = record.types[record.count];
+		uint64_t & arg = record.args[record.count++];
+
+		if constexpr (std::is_same<T, const char *>::value || std::is_same<T, char *>::value)
+		{
+			// Copied in, the string may be gone by the time the record is formatted
+			type = AsyncLogRecord::ARG_STR;
+			arg = text;
+
+			for (size_t i = 0; value != NULL && value[i] != '\0' && text < ASYNC_LOG_TEXT_SZ - 1; i++)
+			{
+				record.text[text++] = value[i];
+			}
+
+			if (text < ASYNC_LOG_TEXT_SZ)
+				record.text[text++] = '\0';
+		}
+		else if constexpr (std::is_floating_point<T>::value)
+		{
+			type = AsyncLogRecord::ARG_DOUBLE;
+			double d = static_cast<double>(value);
+			std::memcpy(&arg, &d, sizeof(arg));
+		}
+		else if constexpr (std::is_pointer<T>::value)
+		{
+			type = AsyncLogRecord::ARG_PTR;
+			arg = reinterpret_cast<uintptr_t>(value);
+		}
+		else if constexpr (std::is_signed<T>::value || std::is_enum<T>::value)
+		{
+			type = AsyncLogRecord::ARG_INT;
+			arg = static_cast<uint64_t>(static_cast<int64_t>(value));
+		}
+		else
+		{
+			static_assert(std::is_integral<T>::value, "AsyncLog arguments must be printf compatible");
+			type = AsyncLogRecord::ARG_UINT;
+			arg = static_cast<uint64_t>(value);
+		}
+	}
+};
+
+}
+
+// Same as mlibc_dbg/inf/wrn/err, but record & leave the formatting to the AsyncLog thread when it is running
+#define hgb_log(level, format, ...) \
+	do \
+	{ \
+		static const hgb::AsyncLogSite hgb_log_site = { level, format, __FILE__, __LINE__ }; \
+		if (mlibc_log_enabled(level)) \
+			hgb::AsyncLog::log(hgb_log_site, ##__VA_ARGS__); \
+	} while (0)
+
+#define hgb_dbg(format, ...) hgb_log(MLIBC_LOG_LEVEL_DBG, format, ##__VA_ARGS__)
+#define hgb_inf(format, ...) hgb_log(MLIBC_LOG_LEVEL_INF, format, ##__VA_ARGS__)
+#define hgb_wrn(format, ...) hgb_log(MLIBC_LOG_LEVEL_WRN, format, ##__VA_ARGS__)
+#define hgb_err(format, ...) hgb_log(MLIBC_LOG_LEVEL_ERR, format, ##__VA_ARGS__)
+
+#endif // ASYNC_LOG_H
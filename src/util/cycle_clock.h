@@ -0,0 +1,54 @@
+#ifndef CYCLE_CLOCK_H
+#define CYCLE_CLOCK_H
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define CYCLE_CLOCK_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLE_CLOCK_TSC 1
+#else
+#define CYCLE_CLOCK_TSC 0
+#endif
+
+namespace hgb
+{
+
+#define CYCLE_CLOCK_CALIBRATE_MS	10	// time stamp counter rate measurement on first use
+
+// Cheapest monotonic tick source, the time stamp counter where there is one, steady_clock nanoseconds otherwise
+inline uint64_t cycleClock()
+{
+#if CYCLE_CLOCK_TSC
+	return __rdtsc();
+#else
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// Nanoseconds per cycleClock() tick, the first call blocks for the measurement
+inline double cycleClockNs()
+{
+#if CYCLE_CLOCK_TSC
+	static const double ns_per_tick = []()
+	{
+		auto clock_start = std::chrono::steady_clock::now();
+		uint64_t ticks_start = cycleClock();
+		std::this_thread::sleep_for(std::chrono::milliseconds(CYCLE_CLOCK_CALIBRATE_MS));
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - clock_start).count();
+		return ns / static_cast<double>(cycleClock() - ticks_start);
+	}();
+
+	return ns_per_tick;
+#else
+	return 1.0;
+#endif
+}
+
+}
+
+#endif // CYCLE_CLOCK_H
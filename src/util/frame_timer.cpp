@@ -0,0 +1,151 @@
+#include "frame_timer.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "3rdparty/mlibc_log.h"
+
+namespace hgb
+{
+
+static const char * FRAME_TIMER_NAMES[FRAME_TIMER_SECTIONS] =
+{
+	"emulate",
+	"ppu",
+	"publish",
+	"present",
+	"events"
+};
+
+FrameTimer::FrameTimer() :
+	m_frame(),
+	m_total(),
+	m_max(),
+	m_total_max(0),
+	m_frames(0),
+	m_histogram()
+{
+	// Calibrate now rather than on the first summary
+	cycleClockNs();
+
+	mlibc_dbg("FrameTimer::FrameTimer()");
+}
+
+void FrameTimer::endFrame()
+{
+	uint64_t total = 0;
+
+	for (int section = 0; section < FRAME_TIMER_SECTIONS; section++)
+	{
+		uint64_t ticks = m_frame[section];
+
+		m_total[section] += ticks;
+		m_max[section] = std::max(m_max[section], ticks);
+		m_frame[section] = 0;
+
+		if ((FRAME_TIMER_NESTED & (1 << section)) == 0)
+			total += ticks;
+	}
+
+	m_total_max = std::max(m_total_max, total);
+	m_histogram[bucket(static_cast<uint64_t>(total * cycleClockNs() / 1000.0))]++;
+	m_frames++;
+}
+
+FrameTimerStats FrameTimer::getStats()
+{
+	FrameTimerStats stats = {};
+	double us_per_tick = cycleClockNs() / 1000.0;
+
+	stats.frames = m_frames;
+	std::copy(m_histogram, m_histogram + FRAME_TIMER_BUCKETS, stats.histogram);
+
+	if (m_frames == 0)
+		return stats;
+
+	for (int section = 0; section < FRAME_TIMER_SECTIONS; section++)
+	{
+		stats.mean_us[section] = m_total[section] * us_per_tick / m_frames;
+		stats.max_us[section] = m_max[section] * us_per_tick;
+	}
+
+	// Upper bound of the bucket the percentile falls in
+	uint64_t count = 0;
+	for (int i = 0; i < FRAME_TIMER_BUCKETS; i++)
+	{
+		count += m_histogram[i];
+
+		if (stats.p50_us == 0.0 && count * 2 >= m_frames)
+			stats.p50_us = static_cast<double>(getBucketUs(i + 1));
+
+		if (stats.p99_us == 0.0 && count * 100 >= m_frames * 99)
+			stats.p99_us = static_cast<double>(getBucketUs(i + 1));
+	}
+
+	stats.total_max_us = m_total_max * us_per_tick;
+
+	return stats;
+}
+
+void FrameTimer::resetStats()
+{
+	std::memset(m_total, 0, sizeof(m_total));
+	std::memset(m_max, 0, sizeof(m_max));
+	std::memset(m_histogram, 0, sizeof(m_histogram));
+	m_total_max = 0;
+	m_frames = 0;
+}
+
+const char * FrameTimer::getName(int section)
+{
+	return (section >= 0 && section < FRAME_TIMER_SECTIONS) ? FRAME_TIMER_NAMES[section] : "?";
+}
+
+std::string FrameTimer::format(const FrameTimerStats & stats)
+{
+	char buffer[128];
+	snprintf(buffer, sizeof(buffer), "frames: %llu", static_cast<unsigned long long>(stats.frames));
+	std::string line = buffer;
+
+	for (int section = 0; section < FRAME_TIMER_SECTIONS; section++)
+	{
+		if (stats.max_us[section] == 0.0)
+			continue;
+
+		snprintf(buffer, sizeof(buffer), ", %s: %.1fus (max %.1fus)", getName(section), stats.mean_us[section], stats.max_us[section]);
+		line += buffer;
+	}
+
+	snprintf(buffer, sizeof(buffer), ", frame p50: %.0fus, p99: %.0fus, max: %.1fus", stats.p50_us, stats.p99_us, stats.total_max_us);
+	line += buffer;
+
+	return line;
+}
+
+uint64_t FrameTimer::getBucketUs(int bucket)
+{
+	if (bucket < 4)
+		return static_cast<uint64_t>(bucket);
+
+	int msb = bucket / 4 + 1;
+
+	return static_cast<uint64_t>(4 + bucket % 4) << (msb - 2);
+}
+
+int FrameTimer::bucket(uint64_t us)
+{
+	if (us < 4)
+		return static_cast<int>(us);
+
+	// Power of two from the top bit, quarter from the two below it
+	int msb = 63;
+	while ((us >> msb) == 0)
+	{
+		msb--;
+	}
+
+	int bucket = (msb - 1) * 4 + static_cast<int>((us >> (msb - 2)) & 3);
+
+	return std::min(bucket, FRAME_TIMER_BUCKETS - 1);
+}
+
+}
@@ -0,0 +1,102 @@
+#ifndef FRAME_TIMER_H
+#define FRAME_TIMER_H
+
+#include <cstdint>
+#include <string>
+#include "util/cycle_clock.h"
+
+namespace hgb
+{
+
+// Timed sections
+#define FRAME_TIMER_EMULATE		0	// Emulator::runFrame(), CPU & memory, PPU included
+#define FRAME_TIMER_PPU			1	// PPU line rendering, or the hand-off to the render worker when pipelined
+#define FRAME_TIMER_PUBLISH		2	// copying the frame & memory out of the emulation thread
+#define FRAME_TIMER_PRESENT		3	// window blits & presentation
+#define FRAME_TIMER_EVENTS		4	// SDL event handling
+#define FRAME_TIMER_SECTIONS	5
+// Sections timed inside another one, left out of the frame total
+#define FRAME_TIMER_NESTED		(1 << FRAME_TIMER_PPU)
+// Frame total histogram, 4 buckets per power of two microseconds
+#define FRAME_TIMER_BUCKETS		96
+
+struct FrameTimerStats
+{
+	// # of frames ended
+	uint64_t frames;
+	// Microseconds per frame of every section
+	double mean_us[FRAME_TIMER_SECTIONS];
+	double max_us[FRAME_TIMER_SECTIONS];
+	// Frame total, percentiles are bucket upper bounds
+	double p50_us;
+	double p99_us;
+	double total_max_us;
+	uint64_t histogram[FRAME_TIMER_BUCKETS];
+};
+
+// Host time spent per frame in each section, fed by FrameTimerScope.
+// One per thread, the sections a thread times end with its own endFrame().
+class FrameTimer
+{
+public:
+	FrameTimer();
+
+	inline void add(int section, uint64_t ticks)
+	{
+		m_frame[section] += ticks;
+	}
+
+	// Fold the sections timed since the last call into the totals & histogram
+	void endFrame();
+
+	FrameTimerStats getStats();
+	void resetStats();
+
+	static const char * getName(int section);
+	// One line summary of the sections that were timed
+	static std::string format(const FrameTimerStats & stats);
+	// Bucket lower bound in microseconds
+	static uint64_t getBucketUs(int bucket);
+private:
+	static int bucket(uint64_t us);
+
+	uint64_t m_frame[FRAME_TIMER_SECTIONS];
+	uint64_t m_total[FRAME_TIMER_SECTIONS];
+	uint64_t m_max[FRAME_TIMER_SECTIONS];
+	uint64_t m_total_max;
+	uint64_t m_frames;
+	uint64_t m_histogram[FRAME_TIMER_BUCKETS];
+};
+
+// Times its own lifetime into a section, a NULL timer reads no clock
+class FrameTimerScope
+{
+public:
+	FrameTimerScope(
+		FrameTimer * timer,
+		int section
+	) :
+		m_timer(timer),
+		m_section(section),
+		m_start((timer != nullptr) ? cycleClock() : 0)
+	{
+
+	}
+
+	~FrameTimerScope()
+	{
+		if (m_timer != nullptr)
+			m_timer->add(m_section, cycleClock() - m_start);
+	}
+
+	FrameTimerScope(const FrameTimerScope &) = delete;
+	FrameTimerScope & operator=(const FrameTimerScope &) = delete;
+private:
+	FrameTimer * m_timer;
+	int m_section;
+	uint64_t m_start;
+};
+
+}
+
+#endif // FRAME_TIMER_H
@@ -0,0 +1,29 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace hgb
+{
+
+#define HASH_FNV1A_SEED	0xCBF29CE484222325ULL
+
+// 64-bit FNV-1a, pass the previous result as seed to hash several blocks as one
+inline uint64_t fnv1a(const void * data, size_t size, uint64_t seed = HASH_FNV1A_SEED)
+{
+	const uint8_t * bytes = static_cast<const uint8_t *>(data);
+	uint64_t h = seed;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		h ^= bytes[i];
+		h *= 0x100000001B3ULL;
+	}
+
+	return h;
+}
+
+}
+
+#endif // HASH_H
@@ -0,0 +1,81 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+namespace hgb
+{
+
+// Bounded lock-free single producer, single consumer ring. N must be a power of two.
+// push() is only called from the producer thread, pop() only from the consumer thread.
+template <typename T, size_t N>
+class SPSCQueue
+{
+	static_assert((N & (N - 1)) == 0, "SPSCQueue size must be a power of two");
+public:
+	SPSCQueue() :
+		m_head(0),
+		m_tail_cache(0),
+		m_tail(0),
+		m_head_cache(0)
+	{
+
+	}
+
+	// Add an item, returns false if the queue is full
+	bool push(const T & item)
+	{
+		size_t head = m_head.load(std::memory_order_relaxed);
+
+		// Only look at the consumer index when the cached one says full
+		if (head - m_tail_cache == N)
+		{
+			m_tail_cache = m_tail.load(std::memory_order_acquire);
+
+			if (head - m_tail_cache == N)
+				return false;
+		}
+
+		m_items[head & (N - 1)] = item;
+		m_head.store(head + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	// Take the oldest item, returns false if the queue is empty
+	bool pop(T & item)
+	{
+		size_t tail = m_tail.load(std::memory_order_relaxed);
+
+		if (tail == m_head_cache)
+		{
+			m_head_cache = m_head.load(std::memory_order_acquire);
+
+			if (tail == m_head_cache)
+				return false;
+		}
+
+		item = m_items[tail & (N - 1)];
+		m_tail.store(tail + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	bool empty() const
+	{
+		return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire);
+	}
+private:
+	// Keep producer and consumer indices on separate cache lines, each side caches the other's index
+	// so the shared line is only read when the queue looks full or empty
+	alignas(64) std::atomic<size_t> m_head;
+	size_t m_tail_cache;
+	alignas(64) std::atomic<size_t> m_tail;
+	size_t m_head_cache;
+	T m_items[N];
+};
+
+}
+
+#endif // SPSC_QUEUE_H
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+namespace hgb
+{
+
+// Lock-free triple buffer, one writer publishes complete values, one reader always gets the newest one.
+// Neither side ever waits, the writer overwrites values the reader did not pick up in time.
+template <typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer() :
+		m_back(0),
+		m_middle(1),
+		m_front(2)
+	{
+
+	}
+
+	// Writer, value to fill before publish()
+	T & back()
+	{
+		return m_buffers[m_back];
+	}
+
+	// Writer, hand the back value over to the reader
+	void publish()
+	{
+		m_back = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel) & INDEX;
+	}
+
+	// Reader, pick up the newest published value, returns false if nothing new was published
+	bool update()
+	{
+		if ((m_middle.load(std::memory_order_relaxed) & FRESH) == 0)
+			return false;
+
+		m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX;
+
+		return true;
+	}
+
+	// Reader, value picked up by the last update()
+	const T & front() const
+	{
+		return m_buffers[m_front];
+	}
+private:
+	static const int INDEX = 0x03;
+	static const int FRESH = 0x04;
+
+	T m_buffers[3];
+	int m_back;
+	std::atomic<int> m_middle;
+	int m_front;
+};
+
+}
+
+#endif // TRIPLE_BUFFER_H
\ No newline at end of file
@@ -0,0 +1,116 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hgb
+{
+
+// Runs a fixed set of coarse tasks over a number of worker threads.
+// Every worker starts with a contiguous slice of the task indices and takes from its front,
+// idle workers steal single tasks from the back of the other slices, so long tasks don't leave cores idle.
+class WorkStealingPool
+{
+public:
+	// workers <= 0 means one per hardware thread
+	explicit WorkStealingPool(int workers = 0) :
+		m_workers(workers)
+	{
+		if (m_workers <= 0)
+			m_workers = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+	}
+
+	int getWorkers() const
+	{
+		return m_workers;
+	}
+
+	// Call task(worker, index) once for every index in [0, count), returns when all are done
+	template <typename F>
+	void run(size_t count, F task)
+	{
+		int workers = static_cast<int>(std::min(static_cast<size_t>(m_workers), std::max(count, static_cast<size_t>(1))));
+		std::unique_ptr<Slice[]> slices(new Slice[workers]);
+
+		for (int i = 0; i < workers; i++)
+		{
+			slices[i].begin = count * i / workers;
+			slices[i].end = count * (i + 1) / workers;
+		}
+
+		auto worker = [&](int id)
+		{
+			size_t index;
+
+			while (take(slices[id], index) || steal(slices.get(), workers, id, index))
+			{
+				task(id, index);
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for (int i = 1; i < workers; i++)
+		{
+			threads.emplace_back(worker, i);
+		}
+
+		// The calling thread is worker #0
+		worker(0);
+
+		for (auto & thread : threads)
+		{
+			thread.join();
+		}
+	}
+private:
+	// Task indices [begin, end) not yet taken, padded to keep the locks on separate cache lines
+	struct Slice
+	{
+		std::mutex lock;
+		size_t begin;
+		size_t end;
+		char padding[64];
+	};
+
+	int m_workers;
+
+	static bool take(Slice & slice, size_t & index)
+	{
+		std::lock_guard<std::mutex> guard(slice.lock);
+
+		if (slice.begin == slice.end)
+			return false;
+
+		index = slice.begin++;
+
+		return true;
+	}
+
+	// No tasks are added once run() starts, so one empty sweep means everything left is already taken
+	static bool steal(Slice * slices, int workers, int thief, size_t & index)
+	{
+		for (int i = 1; i < workers; i++)
+		{
+			Slice & victim = slices[(thief + i) % workers];
+			std::lock_guard<std::mutex> guard(victim.lock);
+
+			if (victim.begin == victim.end)
+				continue;
+
+			index = --victim.end;
+
+			return true;
+		}
+
+		return false;
+	}
+};
+
+}
+
+#endif // WORK_STEALING_POOL_H